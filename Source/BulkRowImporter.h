@@ -0,0 +1,175 @@
+#pragma once
+#include "JuceHeader.h"
+#include "DraggableListBox.h"
+#include <deque>
+#include <vector>
+
+//==============================================================================
+
+// Streams a large number of rows into a list without blocking the message
+// thread, e.g. when a session with hundreds of thousands of entries loads.
+// A producer function runs on a background thread and hands over rows in
+// chunks with addRows(). Once per display frame, the queued chunks are passed
+// to appendRows on the message thread within a time budget, and the list is
+// refreshed a single time. The layout is therefore updated once per frame
+// instead of once per row, and the list stays usable while rows arrive.
+//
+// Rows are only ever appended, so a drag that is in progress isn't disturbed.
+template <typename RowType>
+class BulkRowImporter
+    : private juce::Thread
+    , private juce::AsyncUpdater
+{
+public:
+    // Runs on the import thread, should stop early if addRows() returns false
+    using Producer = std::function<void(BulkRowImporter&)>;
+
+    // Runs on the message thread, should move the rows into the data
+    using AppendFunction = std::function<void(std::vector<RowType>& rows)>;
+
+    BulkRowImporter(juce::ListBox& listToUpdate, DraggableListBoxItemData& data, AppendFunction appendRowsToData)
+        : juce::Thread("Bulk row importer")
+        , list(listToUpdate)
+        , modelData(data)
+        , appendRows(std::move(appendRowsToData)) {}
+
+    ~BulkRowImporter() override
+    {
+        cancel();
+    }
+
+    // Reserves room for expectedNumRows more rows in the data (0 if unknown)
+    // and starts calling produce on the import thread.
+    void start(int expectedNumRows, Producer produce)
+    {
+        cancel();
+
+        if (expectedNumRows > 0)
+            modelData.reserveRows(expectedNumRows);
+
+        producer = std::move(produce);
+        producerFinished = false;
+        startTimeMs = juce::Time::getMillisecondCounterHiRes();
+        firstFrameMs = totalMs = -1.0;
+        importing = true;
+
+        frameAttachment = std::make_unique<juce::VBlankAttachment>(&list, [this] { appendQueuedRows(); });
+        startThread();
+    }
+
+    // Stops the producer and drops the rows that haven't been appended yet
+    void cancel()
+    {
+        stopThread(-1);
+        cancelPendingUpdate();
+        frameAttachment = nullptr;
+        importing = false;
+
+        const juce::ScopedLock sl(lock);
+        queuedChunks.clear();
+    }
+
+    // Called by the producer with the next rows, in order. Returns false if
+    // the import was cancelled.
+    bool addRows(std::vector<RowType>&& rows)
+    {
+        if (threadShouldExit()) { return false; }
+
+        if (!rows.empty())
+        {
+            const juce::ScopedLock sl(lock);
+            queuedChunks.push_back(std::move(rows));
+        }
+
+        return true;
+    }
+
+    bool isImporting() const noexcept { return importing; }
+
+    // How long the message thread may spend appending rows in one frame
+    void setMaxMillisecondsPerFrame(double milliseconds) noexcept { maxMillisecondsPerFrame = milliseconds; }
+
+    // Time from start() until the first rows were shown, and until the last
+    // ones were, or -1 if that hasn't happened yet.
+    double getMillisecondsToFirstFrame() const noexcept { return firstFrameMs; }
+    double getTotalMilliseconds() const noexcept { return totalMs; }
+
+    // Called on the message thread once every row has been appended
+    std::function<void()> onFinished;
+
+private:
+    void run() override
+    {
+        producer(*this);
+        producerFinished = true;
+    }
+
+    void appendQueuedRows()
+    {
+        const auto frameStart = juce::Time::getMillisecondCounterHiRes();
+        bool appendedAny = false;
+
+        for (;;)
+        {
+            std::vector<RowType> chunk;
+            {
+                const juce::ScopedLock sl(lock);
+                if (queuedChunks.empty()) { break; }
+
+                chunk = std::move(queuedChunks.front());
+                queuedChunks.pop_front();
+            }
+
+            appendRows(chunk);
+            appendedAny = true;
+
+            if (juce::Time::getMillisecondCounterHiRes() - frameStart >= maxMillisecondsPerFrame)
+                break;
+        }
+
+        if (appendedAny)
+        {
+            list.updateContent();
+
+            if (firstFrameMs < 0.0)
+                firstFrameMs = juce::Time::getMillisecondCounterHiRes() - startTimeMs;
+        }
+
+        // checked before the queue, so rows added just before finishing aren't missed
+        if (producerFinished)
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (queuedChunks.empty())
+                triggerAsyncUpdate();
+        }
+    }
+
+    void handleAsyncUpdate() override
+    {
+        // not from inside the VBlank callback, which this would delete
+        frameAttachment = nullptr;
+        importing = false;
+        totalMs = juce::Time::getMillisecondCounterHiRes() - startTimeMs;
+
+        if (onFinished != nullptr)
+            onFinished();
+    }
+
+    juce::ListBox& list;
+    DraggableListBoxItemData& modelData;
+    AppendFunction appendRows;
+    Producer producer;
+
+    std::unique_ptr<juce::VBlankAttachment> frameAttachment;
+    double maxMillisecondsPerFrame = 4.0;
+    double startTimeMs = 0.0, firstFrameMs = -1.0, totalMs = -1.0;
+    bool importing = false;
+
+    // shared with the import thread
+    std::atomic<bool> producerFinished { false };
+    juce::CriticalSection lock;
+    std::deque<std::vector<RowType>> queuedChunks;
+
+    JUCE_DECLARE_NON_COPYABLE(BulkRowImporter)
+};
@@ -0,0 +1,158 @@
+#include "ColumnarRowStore.h"
+#include "DraggableListBoxSort.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string_view>
+
+
+//==============================================================================
+
+
+juce::uint32 ColumnarRowStore::StringArena::intern(juce::StringRef text)
+{
+    const auto* utf8 = text.text.getAddress();
+    const auto numBytes = std::strlen(utf8);
+    if (numBytes == 0) { return 0; }
+
+    const auto hash = std::hash<std::string_view>()(std::string_view(utf8, numBytes));
+    const auto range = offsetsByHash.equal_range(hash);
+
+    for (auto it = range.first; it != range.second; ++it)
+        if (std::strcmp(bytes.data() + it->second, utf8) == 0)
+            return it->second;
+
+    jassert(bytes.size() + numBytes < std::numeric_limits<juce::uint32>::max());
+    const auto offset = (juce::uint32) bytes.size();
+    bytes.insert(bytes.end(), utf8, utf8 + numBytes + 1);
+    offsetsByHash.emplace(hash, offset);
+    return offset;
+}
+
+void ColumnarRowStore::StringArena::clear()
+{
+    bytes.assign(1, '\0');
+    offsetsByHash.clear();
+}
+
+size_t ColumnarRowStore::StringArena::getMemoryUsage() const
+{
+    // roughly one node plus one bucket per entry for the hash table
+    return bytes.capacity()
+         + offsetsByHash.size() * (sizeof(std::pair<const size_t, juce::uint32>) + 2 * sizeof(void*))
+         + offsetsByHash.bucket_count() * sizeof(void*);
+}
+
+
+//==============================================================================
+
+
+void ColumnarRowStore::reserve(int numRows)
+{
+    forEachColumn([numRows](auto& column) { column.reserve((size_t) juce::jmax(0, numRows)); });
+}
+
+void ColumnarRowStore::clear()
+{
+    forEachColumn([](auto& column) { column.clear(); });
+    arena.clear();
+}
+
+int ColumnarRowStore::addRow(juce::int64 id, juce::StringRef text, int height, juce::uint8 rowFlags)
+{
+    jassert(juce::isPositiveAndNotGreaterThan(height, 0xffff));
+
+    ids.push_back(id);
+    flags.push_back(rowFlags);
+    heights.push_back((juce::uint16) juce::jlimit(0, 0xffff, height));
+    textOffsets.push_back(arena.intern(text));
+    return size() - 1;
+}
+
+void ColumnarRowStore::setHeight(int row, int newHeight)
+{
+    jassert(juce::isPositiveAndNotGreaterThan(newHeight, 0xffff));
+    heights[(size_t) row] = (juce::uint16) juce::jlimit(0, 0xffff, newHeight);
+}
+
+void ColumnarRowStore::swapRows(int row1, int row2)
+{
+    forEachColumn([row1, row2](auto& column) { std::swap(column[(size_t) row1], column[(size_t) row2]); });
+}
+
+void ColumnarRowStore::moveRow(int fromRow, int toRow)
+{
+    if (fromRow == toRow) { return; }
+
+    forEachColumn([fromRow, toRow](auto& column)
+    {
+        const auto from = column.begin() + fromRow;
+        const auto to = column.begin() + toRow;
+
+        if (fromRow < toRow)
+            std::rotate(from, from + 1, to + 1);
+        else
+            std::rotate(to, from, from + 1);
+    });
+}
+
+void ColumnarRowStore::removeRow(int row)
+{
+    forEachColumn([row](auto& column) { column.erase(column.begin() + row); });
+}
+
+void ColumnarRowStore::removeRows(const std::vector<int>& sortedRows)
+{
+    if (sortedRows.empty()) { return; }
+
+    jassert(std::is_sorted(sortedRows.begin(), sortedRows.end()));
+
+    forEachColumn([&sortedRows](auto& column)
+    {
+        size_t write = (size_t) sortedRows.front();
+        auto next = sortedRows.begin();
+
+        for (size_t read = write; read < column.size(); ++read)
+        {
+            if (next != sortedRows.end() && (size_t) *next == read)
+            {
+                ++next;
+                continue;
+            }
+
+            column[write++] = column[read];
+        }
+
+        column.resize(write);
+    });
+}
+
+void ColumnarRowStore::applyPermutation(const juce::Array<int>& newOrder)
+{
+    if (!DraggableListBoxSort::isPermutation(newOrder, size()))
+    {
+        jassertfalse; // newOrder must hold each row index exactly once
+        return;
+    }
+
+    forEachColumn([&newOrder](auto& column)
+    {
+        std::remove_reference_t<decltype(column)> reordered;
+        reordered.reserve(column.size());
+
+        for (auto idx : newOrder)
+            reordered.push_back(column[(size_t) idx]);
+
+        column.swap(reordered);
+    });
+}
+
+size_t ColumnarRowStore::getMemoryUsage() const
+{
+    return ids.capacity() * sizeof(juce::int64)
+         + flags.capacity() * sizeof(juce::uint8)
+         + heights.capacity() * sizeof(juce::uint16)
+         + textOffsets.capacity() * sizeof(juce::uint32)
+         + arena.getMemoryUsage();
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "JuceHeader.h"
+#include <unordered_map>
+#include <vector>
+
+//==============================================================================
+
+// Reference storage for the metadata of a very long list. Each field lives in
+// its own contiguous array (ids, flags, cached heights and text offsets)
+// rather than in one object per row, so a 1M-row list needs a few megabytes
+// and a pass over one field only touches that field's memory. Row text is
+// interned in a single arena, so rows with the same text (e.g. a category
+// name) share it.
+//
+// Hold one in your DraggableListBoxItemData and forward size(), swapRows(),
+// moveRow(), getRowId() and getMemoryUsage() to it.
+class ColumnarRowStore
+{
+public:
+    ColumnarRowStore() = default;
+
+    void reserve(int numRows);
+    void clear();
+
+    // Returns the index of the new row
+    int addRow(juce::int64 id, juce::StringRef text, int height = 0, juce::uint8 flags = 0);
+
+    int size() const noexcept { return (int) ids.size(); }
+
+    juce::int64 getId(int row) const                { return ids[(size_t) row]; }
+    juce::uint8 getFlags(int row) const             { return flags[(size_t) row]; }
+    void setFlags(int row, juce::uint8 newFlags)    { flags[(size_t) row] = newFlags; }
+    int getHeight(int row) const                    { return heights[(size_t) row]; }
+    void setHeight(int row, int newHeight);
+
+    // Points into the arena, valid until the next row is added
+    juce::CharPointer_UTF8 getText(int row) const   { return arena.get(textOffsets[(size_t) row]); }
+    void setText(int row, juce::StringRef newText)  { textOffsets[(size_t) row] = arena.intern(newText); }
+
+    void swapRows(int row1, int row2);
+    void moveRow(int fromRow, int toRow);
+    void removeRow(int row);
+
+    // Removes all of these rows in one pass, the indices must be sorted
+    void removeRows(const std::vector<int>& sortedRows);
+
+    // newOrder[i] is the current index of the row that should end up at i.
+    // Does nothing if newOrder isn't a permutation of the rows.
+    void applyPermutation(const juce::Array<int>& newOrder);
+
+    // Bytes allocated by the columns and the text arena. Text of removed rows
+    // stays in the arena until clear().
+    size_t getMemoryUsage() const;
+
+private:
+    class StringArena
+    {
+    public:
+        juce::uint32 intern(juce::StringRef text);
+        juce::CharPointer_UTF8 get(juce::uint32 offset) const { return juce::CharPointer_UTF8(bytes.data() + offset); }
+        void clear();
+        size_t getMemoryUsage() const;
+
+    private:
+        std::vector<char> bytes { '\0' };   // offset 0 is the empty string
+        std::unordered_multimap<size_t, juce::uint32> offsetsByHash;
+    };
+
+    template <typename Function>
+    void forEachColumn(Function&& f)
+    {
+        f(ids);
+        f(flags);
+        f(heights);
+        f(textOffsets);
+    }
+
+    std::vector<juce::int64> ids;
+    std::vector<juce::uint8> flags;
+    std::vector<juce::uint16> heights;
+    std::vector<juce::uint32> textOffsets;
+    StringArena arena;
+};
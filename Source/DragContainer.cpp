@@ -9,6 +9,7 @@
 */
 
 #include "DragContainer.h"
+#include "DragProfiler.h"
 
 
 //==============================================================================
@@ -64,8 +65,17 @@ public:
         if (isOpaque())
             g.fillAll(Colours::white);
 
+        // Resampling the snapshot on every repaint is wasteful while it moves,
+        // so it's converted to the display's pixel density once and then drawn
+        // one image pixel per device pixel, which the renderers do as a blit.
+        const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (deviceImage.isNull() || scale != deviceScale)
+            prepareDeviceImage(scale);
+
         g.setOpacity(1.0f);
-        g.drawImage(image.getImage(), getLocalBounds().toFloat());
+        g.setImageResamplingQuality(Graphics::lowResamplingQuality);
+        g.drawImageTransformed(deviceImage, AffineTransform::scale(1.0f / deviceScale));
     }
 
     void mouseUp(const MouseEvent& e) override
@@ -109,6 +119,8 @@ public:
 
     void updateLocation(const bool canDoExternalDrag, Point<int> screenPos)
     {
+        DRAG_PROFILE_SCOPE(updateLocation);
+
         DropTarget::SourceDetails& details = sourceDetails;
 
         setNewScreenPos(screenPos);
@@ -139,6 +151,9 @@ public:
 
             if (getCurrentlyOver() != nullptr)
                 lastTimeOverTarget = now;
+            else if (now > lastTimeOverTarget + RelativeTime::milliseconds(700)
+                     && checkForExternalDrag(details, screenPos))
+                return; // handed over to the OS, this object has been deleted
         }
 
         forceMouseCursorUpdate();
@@ -147,10 +162,25 @@ public:
     void updateImage(const ScaledImage& newImage)
     {
         image = newImage;
+        deviceImage = {};
         updateSize();
         repaint();
     }
 
+    // Converts the drag image once for the display the drag starts on
+    void prepareForDisplayAt(Point<int> screenPos)
+    {
+        if (auto* display = Desktop::getInstance().getDisplays().getDisplayForPoint(screenPos))
+            prepareDeviceImage((float)(display->scale * Desktop::getInstance().getGlobalScaleFactor()));
+    }
+
+    // When set, the image is a desktop window floating over this component
+    // rather than a child of it, but only targets inside it are found.
+    Component::SafePointer<Component> overlayRoot;
+
+    // The DragContainer's component when the image is a desktop window
+    Component::SafePointer<Component> containerComponent;
+
     void timerCallback() override
     {
         forceMouseCursorUpdate();
@@ -179,6 +209,7 @@ public:
     {
         if (key == KeyPress::escapeKey)
         {
+            owner.dragOperationCancelled(sourceDetails);
             dismissWithAnimation(true);
             deleteSelf();
             return true;
@@ -195,10 +226,26 @@ public:
     // (overridden to avoid beeps when dragging)
     void inputAttemptWhenModal() override {}
 
+    // The snapshot and its copy at device resolution
+    size_t getImageMemoryUsage() const
+    {
+        return getPixelBytes(image.getImage()) + getPixelBytes(deviceImage);
+    }
+
+    static size_t getPixelBytes(const Image& im)
+    {
+        if (!im.isValid()) { return 0; }
+
+        const size_t bytesPerPixel = im.getFormat() == Image::SingleChannel ? 1 : (im.getFormat() == Image::RGB ? 3 : 4);
+        return (size_t)im.getWidth() * (size_t)im.getHeight() * bytesPerPixel;
+    }
+
     DropTarget::SourceDetails sourceDetails;
 
 private:
     ScaledImage image;
+    Image deviceImage;
+    float deviceScale = 0.0f;
     DragContainer& owner;
     WeakReference<Component> mouseDragSource, currentlyOverComp;
     const Point<int> imageOffset;
@@ -207,6 +254,17 @@ private:
     int originalInputSourceIndex;
     MouseInputSource::InputSourceType originalInputSourceType;
 
+    void prepareDeviceImage(float scale)
+    {
+        const auto bounds = image.getScaledBounds() * (double)scale;
+        deviceImage = Image(Image::ARGB, jmax(1, roundToInt(bounds.getWidth())), jmax(1, roundToInt(bounds.getHeight())), true);
+        deviceScale = scale;
+
+        Graphics g(deviceImage);
+        g.setImageResamplingQuality(Graphics::highResamplingQuality);
+        g.drawImage(image.getImage(), deviceImage.getBounds().toFloat());
+    }
+
     void updateSize()
     {
         const auto bounds = image.getScaledBounds().toNearestInt();
@@ -223,26 +281,103 @@ private:
         return dynamic_cast<DropTarget*> (currentlyOverComp.get());
     }
 
-    static Component* findDesktopComponentBelow(Point<int> screenPos)
+    // The desktop windows in z-order with their screen bounds, kept for the
+    // lifetime of the drag so that each mouse move only hit-tests the windows
+    // that actually contain the point. Adding, removing, moving or reordering
+    // a window invalidates it.
+    class DesktopWindowCache : private ComponentListener
     {
-        auto& desktop = Desktop::getInstance();
+    public:
+        explicit DesktopWindowCache(const Component& imageComponent) : dragImage(imageComponent) {}
+        ~DesktopWindowCache() override { clear(); }
+
+        Component* findComponentAt(Point<int> screenPos)
+        {
+            if (isDirty || Desktop::getInstance().getNumComponents() != numDesktopComponents)
+                rebuild();
 
-        for (auto i = desktop.getNumComponents(); --i >= 0;)
+            for (auto i = windows.size(); --i >= 0;)
+            {
+                auto& window = windows.getReference(i);
+
+                if (!window.screenBounds.contains(screenPos))
+                    continue;
+
+                auto* desktopComponent = window.component.getComponent();
+                if (desktopComponent == nullptr) { continue; }
+
+                auto dPoint = desktopComponent->getLocalPoint(nullptr, screenPos);
+
+                if (auto* c = desktopComponent->getComponentAt(dPoint))
+                {
+                    auto cPoint = c->getLocalPoint(desktopComponent, dPoint);
+
+                    if (c->hitTest(cPoint.getX(), cPoint.getY()))
+                        return c;
+                }
+            }
+
+            return nullptr;
+        }
+
+    private:
+        struct Window
+        {
+            Component::SafePointer<Component> component;
+            Rectangle<int> screenBounds;
+        };
+
+        void rebuild()
         {
-            auto* desktopComponent = desktop.getComponent(i);
-            auto dPoint = desktopComponent->getLocalPoint(nullptr, screenPos);
+            clear();
 
-            if (auto* c = desktopComponent->getComponentAt(dPoint))
+            auto& desktop = Desktop::getInstance();
+            numDesktopComponents = desktop.getNumComponents();
+
+            for (auto i = 0; i < numDesktopComponents; ++i)
             {
-                auto cPoint = c->getLocalPoint(desktopComponent, dPoint);
+                auto* desktopComponent = desktop.getComponent(i);
+
+                // the drag image moves on every mouse event and never takes
+                // the mouse, so watching it would just keep the cache dirty
+                if (desktopComponent == &dragImage)
+                    continue;
+
+                // hidden windows are watched too, so showing one mid-drag
+                // makes it a target
+                desktopComponent->addComponentListener(this);
+                watched.add(desktopComponent);
 
-                if (c->hitTest(cPoint.getX(), cPoint.getY()))
-                    return c;
+                if (desktopComponent->isVisible())
+                    windows.add({ desktopComponent, desktopComponent->getScreenBounds() });
             }
+
+            isDirty = false;
         }
 
-        return nullptr;
-    }
+        void clear()
+        {
+            for (auto& c : watched)
+                if (c != nullptr)
+                    c->removeComponentListener(this);
+
+            watched.clearQuick();
+            windows.clearQuick();
+        }
+
+        void componentMovedOrResized(Component&, bool, bool) override { isDirty = true; }
+        void componentBroughtToFront(Component&) override             { isDirty = true; }
+        void componentVisibilityChanged(Component&) override          { isDirty = true; }
+        void componentBeingDeleted(Component&) override               { isDirty = true; }
+
+        const Component& dragImage;
+        Array<Component::SafePointer<Component>> watched;
+        Array<Window> windows;     // the visible ones, back to front
+        int numDesktopComponents = -1;
+        bool isDirty = true;
+    };
+
+    mutable DesktopWindowCache desktopWindows { *this };
 
     Point<int> transformOffsetCoordinates(const Component* const sourceComponent, Point<int> offsetInSource) const
     {
@@ -252,10 +387,15 @@ private:
     DropTarget* findTarget(Point<int> screenPos, Point<int>& relativePos,
         Component*& resultComponent) const
     {
+        DRAG_PROFILE_SCOPE(findTarget);
+
         auto* hit = getParentComponent();
 
         if (hit == nullptr)
-            hit = findDesktopComponentBelow(screenPos);
+            hit = overlayRoot.getComponent();
+
+        if (hit == nullptr)
+            hit = desktopWindows.findComponentAt(screenPos);
         else
             hit = hit->getComponentAt(hit->getLocalPoint(nullptr, screenPos));
 
@@ -284,21 +424,77 @@ private:
 
     void setNewScreenPos(Point<int> screenPos)
     {
+        DRAG_PROFILE_SCOPE(setNewScreenPos);
+
         auto newPos = screenPos - imageOffset;
 
-        if (auto* p = getParentComponent())
-            newPos = p->getLocalPoint(nullptr, newPos);
+        // A desktop image is positioned as if it were a child of the
+        // container, or of the target it's over when it can leave the
+        // container, so dragImageMove() never sees screen coordinates.
+        Component* positionRoot = getParentComponent();
+
+        if (positionRoot == nullptr)
+            positionRoot = overlayRoot != nullptr ? overlayRoot.getComponent() : currentlyOverComp.get();
+
+        if (positionRoot == nullptr)
+            positionRoot = containerComponent.getComponent();
+
+        if (positionRoot != nullptr)
+            newPos = positionRoot->getLocalPoint(nullptr, newPos);
 
         if (auto* target = getCurrentlyOver())
         {
             target->dragImageMove(newPos);
         }
-        
+
+        if (getParentComponent() == nullptr && positionRoot != nullptr)
+            newPos = positionRoot->localPointToGlobal(newPos);
+
         setTopLeftPosition(newPos);
     }
 
+    // Returns true if the drag was handed over to the OS, in which case this
+    // object has deleted itself.
+    bool checkForExternalDrag(DropTarget::SourceDetails& details, Point<int> screenPos)
+    {
+        if (hasCheckedForExternalDrag)
+            return false;
+
+        if (Desktop::getInstance().findComponentAt(screenPos) != nullptr)
+            return false;
+
+        hasCheckedForExternalDrag = true;
+
+        if (!ComponentPeer::getCurrentModifiersRealtime().isAnyMouseButtonDown())
+            return false;
+
+        String text;
+
+        if (owner.shouldDropTextWhenDraggedExternally(details, text) && text.isNotEmpty())
+        {
+            // the container may be gone by the time the OS drag finishes
+            Component::SafePointer<Component> ownerComponent(dynamic_cast<Component*> (&owner));
+
+            MessageManager::callAsync([text, ownerComponent]
+            {
+                DragAndDropContainer::performExternalDragDropOfText(text, nullptr, [text, ownerComponent]
+                {
+                    if (auto* container = dynamic_cast<DragContainer*> (ownerComponent.getComponent()))
+                        container->externalDragFinished(text);
+                });
+            });
+
+            deleteSelf();
+            return true;
+        }
+
+        return false;
+    }
+
     void sendDragMove(DropTarget::SourceDetails& details) const
     {
+        DRAG_PROFILE_SCOPE(sendDragMove);
+
         if (auto* target = getCurrentlyOver())
             if (target->isInterestedInDragSource(details))
                 target->itemDragMove(details);
@@ -411,8 +607,15 @@ void DragContainer::startDragging(const var& sourceDescription,
     auto* dragImageComponent = dragImageComponents.add(new DragImageComponent(imageToUse.image, sourceDescription, sourceComponent,
         draggingSource, *this, imageToUse.offset.roundToInt()));
 
-    if (allowDraggingToExternalWindows)
+    if (allowDraggingToExternalWindows || useOverlayWindow)
     {
+        auto* thisComp = dynamic_cast<Component*> (this);
+        jassert(thisComp != nullptr);   // Your DragContainer needs to be a Component!
+        dragImageComponent->containerComponent = thisComp;
+
+        if (!allowDraggingToExternalWindows)
+            dragImageComponent->overlayRoot = thisComp;
+
         if (!Desktop::canUseSemiTransparentWindows())
             dragImageComponent->setOpaque(true);
 
@@ -433,6 +636,7 @@ void DragContainer::startDragging(const var& sourceDescription,
         }
     }
 
+    dragImageComponent->prepareForDisplayAt(lastMouseDown);
     dragImageComponent->sourceDetails.localPosition = sourceComponent->getLocalPoint(nullptr, lastMouseDown);
     dragImageComponent->updateLocation(false, lastMouseDown);
 
@@ -446,11 +650,26 @@ void DragContainer::startDragging(const var& sourceDescription,
     dragOperationStarted(dragImageComponent->sourceDetails);
 }
 
+void DragContainer::setDragImageUsesOverlayWindow(bool shouldUseOverlay)
+{
+    useOverlayWindow = shouldUseOverlay;
+}
+
 bool DragContainer::isDragAndDropActive() const
 {
     return dragImageComponents.size() > 0;
 }
 
+size_t DragContainer::getDragImageMemoryUsage() const
+{
+    size_t total = 0;
+
+    for (auto* dragImageComponent : dragImageComponents)
+        total += dragImageComponent->getImageMemoryUsage();
+
+    return total;
+}
+
 var DragContainer::getCurrentDragDescription() const
 {
     // If you are performing drag and drop in a multi-touch environment then
@@ -479,6 +698,9 @@ DragContainer* DragContainer::findParentDragContainerFor(Component* c)
 
 void DragContainer::dragOperationStarted(const DropTarget::SourceDetails&) {}
 void DragContainer::dragOperationEnded(const DropTarget::SourceDetails&) {}
+void DragContainer::dragOperationCancelled(const DropTarget::SourceDetails&) {}
+bool DragContainer::shouldDropTextWhenDraggedExternally(const DropTarget::SourceDetails&, String&) { return false; }
+void DragContainer::externalDragFinished(const String&) {}
 
 const MouseInputSource* DragContainer::getMouseInputSourceForDrag(Component* sourceComponent,
     const MouseInputSource* inputSourceCausingDrag)
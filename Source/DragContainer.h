@@ -46,9 +46,19 @@ public:
         const Point<int>* imageOffsetFromMouse = nullptr,
         const MouseInputSource* inputSourceCausingDrag = nullptr);
 
+    // Puts the drag image in its own borderless window floating above this
+    // container instead of making it a child component. Moving a window just
+    // moves its pixels, so whatever is underneath (e.g. the list) doesn't get
+    // repainted as the image passes over it. Targets are still only looked
+    // for inside this container.
+    void setDragImageUsesOverlayWindow(bool shouldUseOverlay);
+
     bool isDragAndDropActive() const;
     var getCurrentDragDescription() const;
 
+    // Bytes held by the images of the drags in progress, 0 when there's none
+    size_t getDragImageMemoryUsage() const;
+
     //void setCurrentDragImage(const ScaledImage& newImage);
 
     static DragContainer* findParentDragContainerFor(Component* childComponent);
@@ -57,10 +67,23 @@ protected:
     virtual void dragOperationStarted(const DropTarget::SourceDetails&);
     virtual void dragOperationEnded(const DropTarget::SourceDetails&);
 
+    // Called when the drag is cancelled with the escape key, before the
+    // target under the mouse gets itemDragExit() and dragOperationEnded() is
+    // called.
+    virtual void dragOperationCancelled(const DropTarget::SourceDetails&);
+
+    // Called when the mouse is dragged outside every window of this app.
+    // Return true and fill in text to hand the drag over to the OS as an
+    // external text drag. externalDragFinished() is called with the same
+    // text once that drag is over.
+    virtual bool shouldDropTextWhenDraggedExternally(const DropTarget::SourceDetails&, String& text);
+    virtual void externalDragFinished(const String& text);
+
 private:
     //==============================================================================
     class DragImageComponent;
     OwnedArray<DragImageComponent> dragImageComponents;
+    bool useOverlayWindow = false;
 
     const MouseInputSource* getMouseInputSourceForDrag(Component* sourceComponent, const MouseInputSource* inputSourceCausingDrag);
     bool isAlreadyDragging(Component* sourceComponent) const noexcept;
@@ -0,0 +1,190 @@
+#include "DragProfiler.h"
+
+#if DRAGLISTBOX_ENABLE_PROFILING
+
+//==============================================================================
+
+namespace
+{
+    // Buckets are powers of two split into 4 steps each, so every bucket is
+    // within 25% of its neighbours. Durations are clamped to 2^32 ns (~4s).
+    constexpr int numBuckets = 4 + 30 * 4;
+
+    int getBucketForNanos(juce::uint32 nanos) noexcept
+    {
+        if (nanos < 4)
+            return (int) nanos;
+
+        const auto highestBit = juce::findHighestSetBit(nanos);
+        const auto step = (int) (nanos >> (highestBit - 2)) & 3;
+        return 4 + (highestBit - 2) * 4 + step;
+    }
+
+    double getBucketMidpointNanos(int bucket) noexcept
+    {
+        if (bucket < 4)
+            return (double) bucket;
+
+        const auto shift = (bucket - 4) / 4;
+        const auto step = (bucket - 4) % 4;
+        const auto lowest = (double) ((juce::uint64) (4 + step) << shift);
+        return lowest + (double) ((juce::uint64) 1 << shift) * 0.5;
+    }
+
+    struct Histogram
+    {
+        std::atomic<juce::uint32> buckets[numBuckets] {};
+        std::atomic<juce::uint64> count { 0 }, totalNanos { 0 }, maxNanos { 0 };
+    };
+
+    Histogram histograms[DragProfiler::numStages];
+
+    const double nanosPerTick = 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond();
+}
+
+void DragProfiler::record(Stage stage, juce::int64 elapsedTicks) noexcept
+{
+    auto& h = histograms[(int) stage];
+    const auto nanos = (juce::uint64) juce::jlimit(0.0, 4294967295.0, (double) elapsedTicks * nanosPerTick);
+
+    h.buckets[getBucketForNanos((juce::uint32) nanos)].fetch_add(1, std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    h.totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+
+    auto previousMax = h.maxNanos.load(std::memory_order_relaxed);
+    while (nanos > previousMax && !h.maxNanos.compare_exchange_weak(previousMax, nanos, std::memory_order_relaxed)) {}
+}
+
+DragProfiler::Summary DragProfiler::getSummary(Stage stage)
+{
+    auto& h = histograms[(int) stage];
+
+    juce::uint32 counts[numBuckets];
+    juce::uint64 total = 0;
+
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        counts[i] = h.buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    Summary summary;
+    summary.count = total;
+
+    if (total == 0)
+        return summary;
+
+    summary.meanMicros = (double) h.totalNanos.load(std::memory_order_relaxed) / (double) h.count.load(std::memory_order_relaxed) * 0.001;
+    summary.maxMicros = (double) h.maxNanos.load(std::memory_order_relaxed) * 0.001;
+
+    auto percentile = [&](double fraction)
+    {
+        const auto wanted = (juce::uint64) std::ceil(fraction * (double) total);
+        juce::uint64 seen = 0;
+
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            seen += counts[i];
+
+            if (seen >= wanted)
+                return getBucketMidpointNanos(i) * 0.001;
+        }
+
+        return summary.maxMicros;
+    };
+
+    summary.p50Micros = percentile(0.5);
+    summary.p90Micros = percentile(0.9);
+    summary.p99Micros = percentile(0.99);
+    return summary;
+}
+
+juce::uint64 DragProfiler::getNumSamples() noexcept
+{
+    juce::uint64 total = 0;
+
+    for (auto& h : histograms)
+        total += h.count.load(std::memory_order_relaxed);
+
+    return total;
+}
+
+void DragProfiler::reset() noexcept
+{
+    for (auto& h : histograms)
+    {
+        for (auto& b : h.buckets)
+            b.store(0, std::memory_order_relaxed);
+
+        h.count.store(0, std::memory_order_relaxed);
+        h.totalNanos.store(0, std::memory_order_relaxed);
+        h.maxNanos.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* DragProfiler::getStageName(Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case Stage::updateLocation:  return "updateLocation";
+        case Stage::setNewScreenPos: return "setNewScreenPos";
+        case Stage::findTarget:      return "findTarget";
+        case Stage::sendDragMove:    return "sendDragMove";
+        case Stage::itemDragMove:    return "itemDragMove";
+        case Stage::swapRows:        return "swapRows";
+        case Stage::updateContent:   return "updateContent";
+        case Stage::rowPaint:        return "row paint";
+        case Stage::numStages:       break;
+    }
+
+    return "";
+}
+
+
+//==============================================================================
+
+
+DragProfilerOverlay::DragProfilerOverlay()
+{
+    setInterceptsMouseClicks(false, false);
+    setOpaque(true);
+    setSize(420, 20 + 16 * DragProfiler::numStages);
+    startTimerHz(4);
+}
+
+void DragProfilerOverlay::timerCallback()
+{
+    const auto numSamples = DragProfiler::getNumSamples();
+
+    if (numSamples != lastNumSamples)
+    {
+        lastNumSamples = numSamples;
+        repaint();
+    }
+}
+
+void DragProfilerOverlay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+    g.setColour(juce::Colours::white);
+    g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+
+    auto area = getLocalBounds().reduced(4, 2);
+    g.drawText("stage                count   mean    p50    p99    max (us)", area.removeFromTop(16), juce::Justification::centredLeft);
+
+    for (int i = 0; i < DragProfiler::numStages; ++i)
+    {
+        const auto stage = (DragProfiler::Stage) i;
+        const auto s = DragProfiler::getSummary(stage);
+
+        g.drawText(juce::String(DragProfiler::getStageName(stage)).paddedRight(' ', 16)
+                     + juce::String(s.count).paddedLeft(' ', 10)
+                     + juce::String(s.meanMicros, 1).paddedLeft(' ', 7)
+                     + juce::String(s.p50Micros, 1).paddedLeft(' ', 7)
+                     + juce::String(s.p99Micros, 1).paddedLeft(' ', 7)
+                     + juce::String(s.maxMicros, 1).paddedLeft(' ', 7),
+                   area.removeFromTop(16), juce::Justification::centredLeft);
+    }
+}
+
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+#include "JuceHeader.h"
+
+// Set this to 1 (e.g. in the Projucer's preprocessor definitions) to time
+// each stage of a drag frame. When it's 0 the DRAG_PROFILE_SCOPE macro expands
+// to nothing and none of the classes below exist.
+#ifndef DRAGLISTBOX_ENABLE_PROFILING
+ #define DRAGLISTBOX_ENABLE_PROFILING 0
+#endif
+
+#if DRAGLISTBOX_ENABLE_PROFILING
+
+#include <atomic>
+
+//==============================================================================
+
+// Collects per-stage timings of the drag pipeline into lock-free histograms.
+// Recording is a couple of relaxed atomic adds, so it can be left running for
+// a whole session and read from any thread.
+class DragProfiler
+{
+public:
+    enum class Stage
+    {
+        updateLocation,
+        setNewScreenPos,
+        findTarget,
+        sendDragMove,
+        itemDragMove,
+        swapRows,
+        updateContent,
+        rowPaint,
+        numStages
+    };
+
+    static constexpr int numStages = (int) Stage::numStages;
+
+    struct Summary
+    {
+        juce::uint64 count = 0;
+        double meanMicros = 0.0, p50Micros = 0.0, p90Micros = 0.0, p99Micros = 0.0, maxMicros = 0.0;
+    };
+
+    static void record(Stage stage, juce::int64 elapsedTicks) noexcept;
+    static Summary getSummary(Stage stage);
+
+    // Samples recorded over all stages, a cheap way to see if anything changed
+    static juce::uint64 getNumSamples() noexcept;
+    static void reset() noexcept;
+    static const char* getStageName(Stage stage) noexcept;
+
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Stage s) noexcept : stage(s), start(juce::Time::getHighResolutionTicks()) {}
+        ~ScopedTimer() { record(stage, juce::Time::getHighResolutionTicks() - start); }
+
+    private:
+        const Stage stage;
+        const juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+};
+
+
+//==============================================================================
+
+
+// Shows the current DragProfiler summaries on top of your UI. It doesn't take
+// mouse clicks, so it can sit over the list it's measuring. It's opaque and
+// only repaints when new samples arrive, so it doesn't make the rows under it
+// repaint and show up in their own row paint numbers.
+class DragProfilerOverlay
+    : public juce::Component
+    , private juce::Timer
+{
+public:
+    DragProfilerOverlay();
+
+    void paint(juce::Graphics&) override;
+
+private:
+    void timerCallback() override;
+
+    juce::uint64 lastNumSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DragProfilerOverlay)
+};
+
+#define DRAG_PROFILE_SCOPE(stage) \
+    const DragProfiler::ScopedTimer JUCE_JOIN_MACRO(dragProfileTimer_, __LINE__) (DragProfiler::Stage::stage)
+
+#else
+
+#define DRAG_PROFILE_SCOPE(stage)
+
+#endif
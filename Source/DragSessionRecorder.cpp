@@ -0,0 +1,265 @@
+#include "DragSessionRecorder.h"
+#include "DraggableListBox.h"
+
+
+//==============================================================================
+
+
+namespace
+{
+    constexpr int traceMagic = 0x54475244; // "DRGT"
+
+    // Version 1 stored time deltas as compressed ints, which overflow after
+    // about 35 minutes between two events. Version 2 stores them as varints.
+    constexpr int traceVersion = 2;
+
+    // 7 bits per byte, lowest first, the top bit set on all but the last
+    void writeVarInt64(juce::OutputStream& out, juce::uint64 value)
+    {
+        while (value >= 0x80)
+        {
+            out.writeByte((char)((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+
+        out.writeByte((char)value);
+    }
+
+    bool readVarInt64(juce::InputStream& in, juce::uint64& value)
+    {
+        value = 0;
+
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (in.isExhausted()) { return false; }
+
+            const auto byte = (juce::uint8)in.readByte();
+            value |= (juce::uint64)(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    void writeOrder(juce::OutputStream& out, const juce::Array<juce::int64>& order)
+    {
+        out.writeCompressedInt(order.size());
+
+        for (auto id : order)
+            out.writeInt64(id);
+    }
+
+    bool readOrder(juce::InputStream& in, juce::Array<juce::int64>& order)
+    {
+        const int num = in.readCompressedInt();
+        if (num < 0) { return false; }
+
+        order.clearQuick();
+        order.ensureStorageAllocated(num);
+
+        for (int i = 0; i < num && !in.isExhausted(); ++i)
+            order.add(in.readInt64());
+
+        return order.size() == num;
+    }
+}
+
+void DragSessionTrace::writeTo(juce::OutputStream& out) const
+{
+    out.writeInt(traceMagic);
+    out.writeCompressedInt(traceVersion);
+    out.writeCompressedInt(events.size());
+
+    juce::int64 lastMicros = 0;
+
+    for (auto& e : events)
+    {
+        const auto micros = (juce::int64)(e.timeMs * 1000.0);
+        out.writeByte((char)e.type);
+        writeVarInt64(out, (juce::uint64)juce::jmax((juce::int64)0, micros - lastMicros));
+        out.writeCompressedInt(e.a);
+        out.writeCompressedInt(e.b);
+        lastMicros = micros;
+    }
+
+    writeOrder(out, initialRowOrder);
+    writeOrder(out, finalRowOrder);
+}
+
+bool DragSessionTrace::readFrom(juce::InputStream& in)
+{
+    events.clearQuick();
+
+    if (in.readInt() != traceMagic)
+        return false;
+
+    const int version = in.readCompressedInt();
+    if (version < 1 || version > traceVersion) { return false; }
+
+    const int numEvents = in.readCompressedInt();
+    if (numEvents < 0) { return false; }
+    events.ensureStorageAllocated(numEvents);
+
+    juce::int64 micros = 0;
+
+    for (int i = 0; i < numEvents; ++i)
+    {
+        if (in.isExhausted()) { return false; }
+
+        const auto type = (EventType)(juce::uint8)in.readByte();
+        juce::uint64 delta = 0;
+
+        if (version == 1)
+            delta = (juce::uint64)juce::jmax(0, in.readCompressedInt());
+        else if (!readVarInt64(in, delta))
+            return false;
+
+        micros += (juce::int64)delta;
+        const int a = in.readCompressedInt();
+        const int b = in.readCompressedInt();
+
+        if ((int)type > (int)EventType::dragCancelled) { return false; }
+
+        events.add({ type, (double)micros * 0.001, a, b });
+    }
+
+    return readOrder(in, initialRowOrder) && readOrder(in, finalRowOrder);
+}
+
+
+//==============================================================================
+
+
+void DragSessionRecorder::start(const juce::Array<juce::int64>& initialRowOrder)
+{
+    trace = {};
+    trace.initialRowOrder = initialRowOrder;
+    startTimeMs = juce::Time::getMillisecondCounterHiRes();
+    recording = true;
+}
+
+void DragSessionRecorder::stop(const juce::Array<juce::int64>& finalRowOrder)
+{
+    trace.finalRowOrder = finalRowOrder;
+    recording = false;
+}
+
+void DragSessionRecorder::record(DragSessionTrace::EventType type, int a, int b)
+{
+    if (recording)
+        trace.events.add({ type, juce::Time::getMillisecondCounterHiRes() - startTimeMs, a, b });
+}
+
+
+//==============================================================================
+
+
+juce::String DragSessionPlayer::Report::toString() const
+{
+    juce::String s;
+    s << numEvents << " events in " << juce::String(processingMs, 3) << " ms"
+      << " (mean " << juce::String(meanEventMs * 1000.0, 1) << " us"
+      << ", max " << juce::String(maxEventMs * 1000.0, 1) << " us"
+      << ", " << juce::String(wallClockMs, 3) << " ms wall clock)";
+
+    if (!mutationsMatch) s << ", model changes differ from the recording";
+    if (!orderMatches)   s << ", final row order differs from the recording";
+
+    return s;
+}
+
+DragSessionPlayer::Report DragSessionPlayer::replay(const DragSessionTrace& trace,
+                                                    DraggableListBox& list,
+                                                    bool realTime,
+                                                    std::function<juce::Array<juce::int64>()> getRowOrder)
+{
+    using Type = DragSessionTrace::EventType;
+
+    Report report;
+    const bool checkOrder = getRowOrder != nullptr && !trace.finalRowOrder.isEmpty();
+
+    if (checkOrder && getRowOrder() != trace.initialRowOrder)
+    {
+        // the list doesn't start from the recorded state, so the result can't match
+        report.orderMatches = false;
+        return report;
+    }
+
+    // record what the replay does to the model, to compare it with the trace
+    DragSessionRecorder replayed;
+    auto* previousRecorder = list.sessionRecorder;
+    list.setSessionRecorder(&replayed);
+    replayed.start();
+
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+
+    for (auto& e : trace.events)
+    {
+        if (DragSessionTrace::isModelMutation(e.type))
+            continue;
+
+        if (realTime)
+        {
+            const auto due = start + e.timeMs;
+
+            while (juce::Time::getMillisecondCounterHiRes() < due - 2.0)
+                juce::Thread::sleep(1);
+        }
+
+        const auto before = juce::Time::getMillisecondCounterHiRes();
+        DropTarget::SourceDetails details(juce::var(list.modelData.dragRowIdx), nullptr, { e.a, e.b });
+
+        switch (e.type)
+        {
+            case Type::dragStarted:   list.modelData.dragRowIdx = e.a; break;
+            case Type::dragEnter:     list.itemDragEnter(details); break;
+            case Type::dragMove:      list.itemDragMove(details); break;
+            case Type::dragExit:      list.itemDragExit(details); break;
+            case Type::dropped:       list.itemDropped(details); break;
+            case Type::dragEnded:     list.dragOperationEnded(details); break;
+            case Type::dragCancelled: list.dragOperationCancelled(details); break;
+            case Type::autoScrolled:  list.scrollDuringDrag(e.a); break;
+            case Type::rowMoved:
+            case Type::rowDeleted:
+                break;
+        }
+
+        const auto elapsed = juce::Time::getMillisecondCounterHiRes() - before;
+        report.processingMs += elapsed;
+        report.maxEventMs = juce::jmax(report.maxEventMs, elapsed);
+        ++report.numEvents;
+    }
+
+    report.wallClockMs = juce::Time::getMillisecondCounterHiRes() - start;
+    report.meanEventMs = report.numEvents > 0 ? report.processingMs / report.numEvents : 0.0;
+
+    replayed.stop();
+    list.setSessionRecorder(previousRecorder);
+
+    auto mutationsOf = [](const DragSessionTrace& t)
+    {
+        juce::Array<DragSessionTrace::Event> mutations;
+
+        for (auto& e : t.events)
+            if (DragSessionTrace::isModelMutation(e.type))
+                mutations.add(e);
+
+        return mutations;
+    };
+
+    const auto expected = mutationsOf(trace);
+    const auto actual = mutationsOf(replayed.getTrace());
+    report.mutationsMatch = expected.size() == actual.size();
+
+    for (int i = 0; report.mutationsMatch && i < expected.size(); ++i)
+        report.mutationsMatch = expected[i].type == actual[i].type
+                             && expected[i].a == actual[i].a
+                             && expected[i].b == actual[i].b;
+
+    if (checkOrder)
+        report.orderMatches = getRowOrder() == trace.finalRowOrder;
+
+    return report;
+}
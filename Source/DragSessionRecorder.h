@@ -0,0 +1,108 @@
+#pragma once
+#include "JuceHeader.h"
+
+class DraggableListBox;
+
+//==============================================================================
+
+// A recorded drag session: the timestamped drag input a DraggableListBox
+// received, and the changes it made to its model in response.
+struct DragSessionTrace
+{
+    enum class EventType : juce::uint8
+    {
+        dragStarted,    // a = dragged row
+        dragEnter,      // a, b = position relative to the list
+        dragMove,       // a, b = position relative to the list
+        dragExit,
+        dropped,        // a, b = position relative to the list
+        dragEnded,      // a = 1 if the row was dragged outside the list
+        autoScrolled,   // a = pixels scrolled
+        rowMoved,       // a = from, b = to
+        rowDeleted,     // a = row
+        dragCancelled   // added last, so the values above stay the same
+    };
+
+    struct Event
+    {
+        EventType type;
+        double timeMs;  // since the recording started
+        int a, b;
+    };
+
+    static bool isModelMutation(EventType type) noexcept
+    {
+        return type == EventType::rowMoved || type == EventType::rowDeleted;
+    }
+
+    juce::Array<Event> events;
+
+    // Optional snapshots of the row identities, used to check a replay ended
+    // with the same order.
+    juce::Array<juce::int64> initialRowOrder, finalRowOrder;
+
+    // Compact binary form: times are stored as 64-bit varint microsecond
+    // deltas and the other values as JUCE compressed ints. readFrom() also
+    // reads the older format, whose deltas were compressed ints.
+    void writeTo(juce::OutputStream& out) const;
+    bool readFrom(juce::InputStream& in);
+};
+
+
+//==============================================================================
+
+
+// Attach to a DraggableListBox with setSessionRecorder() to capture a trace.
+class DragSessionRecorder
+{
+public:
+    DragSessionRecorder() = default;
+
+    void start(const juce::Array<juce::int64>& initialRowOrder = {});
+    void stop(const juce::Array<juce::int64>& finalRowOrder = {});
+    bool isRecording() const noexcept { return recording; }
+
+    void record(DragSessionTrace::EventType type, int a = 0, int b = 0);
+
+    const DragSessionTrace& getTrace() const noexcept { return trace; }
+
+private:
+    DragSessionTrace trace;
+    double startTimeMs = 0.0;
+    bool recording = false;
+
+    JUCE_DECLARE_NON_COPYABLE(DragSessionRecorder)
+};
+
+
+//==============================================================================
+
+
+// Feeds a trace back into a DraggableListBox without any real mouse input, so
+// customer traces can be used as performance regression fixtures. Only needs
+// a juce::ScopedJuceInitialiser_GUI, the list doesn't have to be on screen.
+class DragSessionPlayer
+{
+public:
+    struct Report
+    {
+        int numEvents = 0;
+        double processingMs = 0.0;      // time spent handling the events only
+        double wallClockMs = 0.0;       // including the waits of a real-time replay
+        double meanEventMs = 0.0, maxEventMs = 0.0;
+        bool mutationsMatch = true;
+        bool orderMatches = true;   // also true when the trace has no order snapshot
+
+        bool passed() const noexcept { return mutationsMatch && orderMatches; }
+        juce::String toString() const;
+    };
+
+    // Replays every event of trace into list. With realTime the events are
+    // spaced out as they were recorded, otherwise they're sent back to back.
+    // If getRowOrder is given and the trace has order snapshots, the list's
+    // order is checked before and after.
+    static Report replay(const DragSessionTrace& trace,
+                         DraggableListBox& list,
+                         bool realTime,
+                         std::function<juce::Array<juce::int64>()> getRowOrder = nullptr);
+};
@@ -0,0 +1,362 @@
+#include "DragStressHarness.h"
+#include "DraggableListBox.h"
+
+#if DRAGLISTBOX_COUNT_ALLOCATIONS
+ #include <cstdlib>
+ #include <new>
+
+namespace
+{
+    // only the thread running the harness is of interest
+    thread_local juce::int64 numAllocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++numAllocations;
+
+    if (auto* p = std::malloc(size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept              { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static juce::int64 getNumAllocations() noexcept { return numAllocations; }
+#else
+static juce::int64 getNumAllocations() noexcept { return 0; }
+#endif
+
+
+//==============================================================================
+
+
+DragStressHarness::DragStressHarness(DraggableListBox& listToTest, std::function<void(int numRows)> addRowsToData)
+    : list(listToTest)
+    , addRows(std::move(addRowsToData)) {}
+
+const char* DragStressHarness::getOperationName(Operation op) noexcept
+{
+    switch (op)
+    {
+        case Operation::startDrag:     return "startDrag";
+        case Operation::moveOver:      return "moveOver";
+        case Operation::autoScroll:    return "autoScroll";
+        case Operation::exitList:      return "exitList";
+        case Operation::enterList:     return "enterList";
+        case Operation::drop:          return "drop";
+        case Operation::dropOutside:   return "dropOutside";
+        case Operation::cancel:        return "cancel";
+        case Operation::numOperations: break;
+    }
+
+    return "";
+}
+
+juce::String DragStressHarness::getSummary() const
+{
+    juce::String s;
+
+    for (int i = 0; i < numOperations; ++i)
+    {
+        const auto op = (Operation) i;
+        const auto& st = stats[i];
+
+        s << juce::String(getOperationName(op)).paddedRight(' ', 12)
+          << juce::String(st.count).paddedLeft(' ', 10) << " calls"
+          << ", mean " << juce::String(st.getMeanMicros(), 1) << " us"
+          << ", max " << juce::String(st.maxMicros, 1) << " us";
+
+       #if DRAGLISTBOX_COUNT_ALLOCATIONS
+        s << ", max " << st.maxAllocations << " allocations";
+       #endif
+
+        s << juce::newLine;
+    }
+
+    return s;
+}
+
+
+//==============================================================================
+
+
+juce::Result DragStressHarness::run(const Options& options)
+{
+    if (list.getWidth() <= 0 || list.getHeight() <= 0)
+        return juce::Result::fail("The list needs a size");
+
+    if (list.modelData.dragRowIdx >= 0)
+        return juce::Result::fail("A drag is already in progress");
+
+    random.setSeed(options.seed);
+    dragging = outside = false;
+    draggedId = -1;
+
+    for (auto& st : stats)
+        st = {};
+
+    if (list.modelData.size() < juce::jmax(1, options.minNumRows))
+    {
+        addRows(options.numRowsToAdd);
+        list.updateContent();
+    }
+
+    refreshExpectedRows();
+
+    if (expectedIds.isEmpty() || expectedIds.getFirst() < 0)
+        return juce::Result::fail("The rows need ids, see DraggableListBoxItemData::getRowId()");
+
+    for (int i = 1; i < expectedIds.size(); ++i)
+        if (expectedIds.getUnchecked(i) == expectedIds.getUnchecked(i - 1))
+            return juce::Result::fail("The row ids must be unique");
+
+    const double microsPerTick = 1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond();
+
+    for (int step = 0; step < options.numSteps; ++step)
+    {
+        if (!dragging && list.modelData.size() < juce::jmax(1, options.minNumRows))
+        {
+            const int numBefore = expectedIds.size();
+            addRows(options.numRowsToAdd);
+            list.updateContent();
+            refreshExpectedRows();
+
+            if (expectedIds.size() != numBefore + options.numRowsToAdd)
+                return juce::Result::fail("addRows() didn't add the rows asked for");
+        }
+
+        const auto op = chooseOperation();
+        const auto allocationsBefore = getNumAllocations();
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        perform(op);
+
+        const auto micros = (double) (juce::Time::getHighResolutionTicks() - start) * microsPerTick;
+        const auto allocations = (int) (getNumAllocations() - allocationsBefore);
+
+        auto& st = stats[(int) op];
+        ++st.count;
+        st.totalMicros += micros;
+        st.maxMicros = juce::jmax(st.maxMicros, micros);
+        st.maxAllocations = juce::jmax(st.maxAllocations, allocations);
+
+        auto result = checkBudgets(options, op, micros, allocations);
+
+        // a drag ending is where state is most likely to be left behind
+        if (result.wasOk() && (!dragging || step % juce::jmax(1, options.checkInvariantsEvery) == 0))
+            result = checkInvariants();
+
+        if (result.failed())
+            return juce::Result::fail("Step " + juce::String(step) + " (" + getOperationName(op) + "): "
+                                      + result.getErrorMessage());
+    }
+
+    if (dragging)
+    {
+        perform(Operation::cancel);
+
+        auto result = checkInvariants();
+        if (result.failed()) { return juce::Result::fail("Final cancel: " + result.getErrorMessage()); }
+    }
+
+    for (int i = 0; i < numOperations; ++i)
+    {
+        const auto& budget = options.budgets[i];
+        const auto mean = stats[i].getMeanMicros();
+
+        if (budget.maxMeanMicros > 0.0 && mean > budget.maxMeanMicros)
+            return juce::Result::fail(juce::String(getOperationName((Operation) i)) + " took "
+                                      + juce::String(mean, 1) + " us on average, the budget is "
+                                      + juce::String(budget.maxMeanMicros, 1) + " us");
+    }
+
+    return juce::Result::ok();
+}
+
+DragStressHarness::Operation DragStressHarness::chooseOperation()
+{
+    if (!dragging)
+        return Operation::startDrag;
+
+    const int r = random.nextInt(100);
+
+    if (outside)
+    {
+        if (r < 40) { return Operation::enterList; }
+        if (r < 70) { return Operation::dropOutside; }
+        return Operation::cancel;
+    }
+
+    if (r < 55) { return Operation::moveOver; }
+    if (r < 65) { return Operation::autoScroll; }
+    if (r < 75) { return Operation::exitList; }
+    if (r < 90) { return Operation::drop; }
+    return Operation::cancel;
+}
+
+juce::Point<int> DragStressHarness::getRandomPositionInList()
+{
+    return { random.nextInt(list.getWidth()), random.nextInt(list.getHeight()) };
+}
+
+// Sends the callbacks in the order DragContainer's drag image sends them,
+// without a drag image. See the class comment.
+void DragStressHarness::perform(Operation op)
+{
+    auto& data = list.modelData;
+    auto position = getRandomPositionInList();
+    DropTarget::SourceDetails details(juce::var(data.dragRowIdx), nullptr, position);
+
+    switch (op)
+    {
+        case Operation::startDrag:
+        {
+            int row = list.getRowContainingPosition(position.x, position.y);
+
+            if (row < 0)
+            {
+                // below the last row, so pick one that is on screen
+                row = random.nextInt(data.size());
+                list.scrollToEnsureRowIsOnscreen(row);
+                position = list.getRowPosition(row, true).getCentre();
+            }
+
+            details = DropTarget::SourceDetails(juce::var(row), nullptr, position);
+
+            // the first move arrives before DraggableListBoxItem::mouseDrag()
+            // has recorded the dragged row
+            list.itemDragEnter(details);
+            list.itemDragMove(details);
+            list.dragOperationStarted(details);
+            data.dragRowIdx = row;
+
+            draggedId = data.getRowId(row);
+            dragging = true;
+            outside = false;
+            break;
+        }
+
+        case Operation::moveOver:
+            list.itemDragMove(details);
+            break;
+
+        case Operation::autoScroll:
+        {
+            const int maxDelta = 3 * juce::jmax(1, list.getRowHeight());
+            list.scrollDuringDrag(random.nextInt({ -maxDelta, maxDelta + 1 }));
+            break;
+        }
+
+        case Operation::exitList:
+            list.itemDragExit(details);
+            outside = true;
+            break;
+
+        case Operation::enterList:
+            list.itemDragEnter(details);
+            list.itemDragMove(details);
+            outside = false;
+            break;
+
+        case Operation::drop:
+            list.itemDropped(details);
+            list.dragOperationEnded(details);
+            dragging = false;
+            break;
+
+        case Operation::dropOutside:
+            list.dragOperationEnded(details);
+            expectedIds.removeFirstMatchingValue(draggedId);
+            dragging = false;
+            break;
+
+        case Operation::cancel:
+            list.dragOperationCancelled(details);
+
+            if (!outside)
+                list.itemDragExit(details);
+
+            list.dragOperationEnded(details);
+            dragging = false;
+            break;
+
+        case Operation::numOperations:
+            jassertfalse;
+            break;
+    }
+}
+
+
+//==============================================================================
+
+
+juce::Array<juce::int64> DragStressHarness::getSortedRowIds() const
+{
+    auto& data = list.modelData;
+    juce::Array<juce::int64> ids;
+    ids.ensureStorageAllocated(data.size());
+
+    for (int i = 0; i < data.size(); ++i)
+        ids.add(data.getRowId(i));
+
+    ids.sort();
+    return ids;
+}
+
+void DragStressHarness::refreshExpectedRows()
+{
+    expectedIds = getSortedRowIds();
+}
+
+juce::Result DragStressHarness::checkInvariants() const
+{
+    auto& data = list.modelData;
+
+    if (data.size() != expectedIds.size())
+        return juce::Result::fail("There are " + juce::String(data.size()) + " rows, expected "
+                                  + juce::String(expectedIds.size()));
+
+    if (getSortedRowIds() != expectedIds)
+        return juce::Result::fail("Rows were lost or duplicated");
+
+    if (dragging)
+    {
+        if (!juce::isPositiveAndBelow(data.dragRowIdx, data.size()))
+            return juce::Result::fail("dragRowIdx " + juce::String(data.dragRowIdx) + " is out of range");
+
+        if (data.getRowId(data.dragRowIdx) != draggedId)
+            return juce::Result::fail("dragRowIdx no longer points at the dragged row");
+
+        if (data.draggingOutsideContainer != outside)
+            return juce::Result::fail("draggingOutsideContainer doesn't match where the drag is");
+    }
+    else
+    {
+        if (data.dragRowIdx != -1 || data.draggingOutsideContainer || list.dragCancelled)
+            return juce::Result::fail("The drag state wasn't reset when the drag ended");
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result DragStressHarness::checkBudgets(const Options& options, Operation op, double micros, int allocations) const
+{
+    const auto& budget = options.budgets[(int) op];
+
+    if (budget.maxMicros > 0.0 && micros > budget.maxMicros)
+        return juce::Result::fail("took " + juce::String(micros, 1) + " us, the budget is "
+                                  + juce::String(budget.maxMicros, 1) + " us");
+
+   #if DRAGLISTBOX_COUNT_ALLOCATIONS
+    if (budget.maxAllocations >= 0 && allocations > budget.maxAllocations)
+        return juce::Result::fail("made " + juce::String(allocations) + " allocations, the budget is "
+                                  + juce::String(budget.maxAllocations));
+   #else
+    juce::ignoreUnused(allocations);
+   #endif
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "JuceHeader.h"
+
+class DraggableListBox;
+
+// Set to 1 to count heap allocations for DragStressHarness' allocation
+// budgets. This replaces the global operator new, so only enable it in
+// builds made for stress testing.
+#ifndef DRAGLISTBOX_COUNT_ALLOCATIONS
+ #define DRAGLISTBOX_COUNT_ALLOCATIONS 0
+#endif
+
+//==============================================================================
+
+// Drives a DraggableListBox through long, random but reproducible sequences
+// of drags: starting drags, moving over rows, auto-scrolling, leaving and
+// re-entering the list, dropping inside and outside it, and cancelling. After
+// every step it checks that no row was lost or duplicated, that dragRowIdx
+// still points at the dragged row, and that the drag state is reset once a
+// drag ends. Every operation is timed against a budget, and optionally
+// counted for allocations.
+//
+// It calls the list's DropTarget and DragContainer callbacks directly, in the
+// order DragContainer's drag image sends them. DragContainer itself is NOT
+// covered: startDragging() needs a real mouse drag, so the drag image, target
+// lookup, Escape handling and the timings of those are never exercised here.
+//
+// Like DragSessionPlayer, it needs no window or mouse, only a
+// juce::ScopedJuceInitialiser_GUI and a list with a size. The list's data
+// must give its rows ids (see DraggableListBoxItemData::getRowId()) and
+// implement deleteRow().
+class DragStressHarness
+{
+public:
+    enum class Operation
+    {
+        startDrag,
+        moveOver,
+        autoScroll,
+        exitList,
+        enterList,
+        drop,
+        dropOutside,
+        cancel,
+        numOperations
+    };
+
+    static constexpr int numOperations = (int) Operation::numOperations;
+
+    // Limits for one kind of operation, a failure when exceeded. For the
+    // times, 0 or a negative value means no limit. For allocations, only a
+    // negative value does, as 0 asks for no allocations at all.
+    struct Budget
+    {
+        double maxMeanMicros = 0.0;
+        double maxMicros = 0.0;
+        int maxAllocations = -1;     // per call, needs DRAGLISTBOX_COUNT_ALLOCATIONS
+    };
+
+    struct Options
+    {
+        juce::int64 seed = 1;
+        int numSteps = 1000000;
+
+        // Checking is O(n log n) in the number of rows
+        int checkInvariantsEvery = 1;
+
+        // Drops outside the list delete rows. Below this many, addRows is
+        // called to top the list back up.
+        int minNumRows = 8;
+        int numRowsToAdd = 64;
+
+        Budget budgets[numOperations];
+    };
+
+    struct OperationStats
+    {
+        juce::int64 count = 0;
+        double totalMicros = 0.0, maxMicros = 0.0;
+        int maxAllocations = 0;
+
+        double getMeanMicros() const noexcept { return count > 0 ? totalMicros / (double) count : 0.0; }
+    };
+
+    // addRows(n) must add n rows with new ids to the list's data
+    DragStressHarness(DraggableListBox& listToTest, std::function<void(int numRows)> addRows);
+
+    // Runs the steps and returns the first invariant or budget failure, with
+    // the step it happened at, or ok.
+    juce::Result run(const Options& options);
+
+    const OperationStats& getStats(Operation op) const noexcept { return stats[(int) op]; }
+    static const char* getOperationName(Operation op) noexcept;
+    juce::String getSummary() const;
+
+private:
+    Operation chooseOperation();
+    void perform(Operation op);
+    juce::Result checkInvariants() const;
+    juce::Result checkBudgets(const Options& options, Operation op, double micros, int allocations) const;
+    juce::Array<juce::int64> getSortedRowIds() const;
+    void refreshExpectedRows();
+    juce::Point<int> getRandomPositionInList();
+
+    DraggableListBox& list;
+    std::function<void(int)> addRows;
+    juce::Random random;
+
+    juce::Array<juce::int64> expectedIds;   // sorted
+    juce::int64 draggedId = -1;
+    bool dragging = false, outside = false;
+
+    OperationStats stats[numOperations];
+
+    JUCE_DECLARE_NON_COPYABLE(DragStressHarness)
+};
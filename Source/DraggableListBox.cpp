@@ -4,10 +4,113 @@
 //==============================================================================
 
 
+void DraggableListBoxItemData::applyPermutation(const juce::Array<int>& newOrder)
+{
+    if (!DraggableListBoxSort::isPermutation(newOrder, size()))
+    {
+        jassertfalse; // newOrder must hold each row index exactly once
+        return;
+    }
+
+    // Walk each cycle of the permutation once, pulling the row that belongs at
+    // the current position into place. Finished positions are marked as fixed
+    // points so every row is swapped at most once.
+    juce::Array<int> order(newOrder);
+
+    for (int start = 0; start < order.size(); ++start)
+    {
+        int current = start;
+
+        while (order.getUnchecked(current) != start)
+        {
+            const int next = order.getUnchecked(current);
+            swapRows(current, next);
+            order.setUnchecked(current, current);
+            current = next;
+        }
+
+        order.setUnchecked(current, current);
+    }
+}
+
+bool DraggableListBoxItemData::endDrag(bool wasCancelled)
+{
+    // a cancelled drag leaves the row where it is, even outside the list
+    const bool deleteDraggedRow = draggingOutsideContainer && !wasCancelled && dragRowIdx >= 0;
+
+    if (deleteDraggedRow)
+        deleteRow(dragRowIdx);
+
+    dragRowIdx = -1;
+    draggingOutsideContainer = false;
+    return deleteDraggedRow;
+}
+
+int DraggableListBoxItemData::moveRow(int fromIdx, int toIdx)
+{
+    const int step = toIdx > fromIdx ? 1 : -1;
+
+    for (int i = fromIdx; i != toIdx; i += step)
+        swapRows(i, i + step);
+
+    return toIdx;
+}
+
+
+//==============================================================================
+
+
+DraggableListBox::~DraggableListBox()
+{
+    // A row still waiting for another process to take it must not leave its
+    // segment behind. Withdrawing settles who has the row.
+    if (pendingExternalHandle.isNotEmpty())
+        settleExternalDrag(SharedMemoryDragChannel::withdraw(pendingExternalHandle)
+                             == SharedMemoryDragChannel::WithdrawResult::consumed, false);
+}
+
+DraggableListBox* DraggableListBox::getSourceList(const SourceDetails& dragSourceDetails) const
+{
+    if (auto* sourceComponent = dragSourceDetails.sourceComponent.get())
+        return sourceComponent->findParentComponentOfClass<DraggableListBox>();
+
+    return nullptr;
+}
+
+bool DraggableListBox::isForeignDrag(const SourceDetails& dragSourceDetails) const
+{
+    auto* source = getSourceList(dragSourceDetails);
+    return source != nullptr && source != this;
+}
+
+bool DraggableListBox::isInterestedInDragSource(const SourceDetails& dragSourceDetails)
+{
+    if (!isForeignDrag(dragSourceDetails))
+        return true;
+
+    auto* source = getSourceList(dragSourceDetails);
+    return source->modelData.dragRowIdx >= 0 && modelData.canInsertRowFrom(source->modelData);
+}
+
 void DraggableListBox::itemDragMove(const SourceDetails& dragSourceDetails)
 {
-    int mouseOverIdx = getRowContainingPosition(dragSourceDetails.localPosition.x,
-        dragSourceDetails.localPosition.y);
+    DRAG_PROFILE_SCOPE(itemDragMove);
+
+    // rows from another list are only inserted once they're dropped
+    if (isForeignDrag(dragSourceDetails)) { return; }
+
+    lastDragPosition = dragSourceDetails.localPosition;
+    record(DragSessionTrace::EventType::dragMove, lastDragPosition.x, lastDragPosition.y);
+    updateAutoScroll();
+    moveDraggedRowUnder(lastDragPosition);
+}
+
+void DraggableListBox::moveDraggedRowUnder(juce::Point<int> position)
+{
+    // the first drag move arrives before the dragged row has been recorded
+    if (modelData.dragRowIdx < 0) { return; }
+
+    int mouseOverIdx = getRowContainingPosition(position.x, position.y);
     if (mouseOverIdx == -1) { return; } // failed finding row
 
     // user is dragging source row over the source row
@@ -17,38 +120,425 @@ void DraggableListBox::itemDragMove(const SourceDetails& dragSourceDetails)
         return;
     }
 
-    // user is dragging source row over another row.
-    modelData.swapRows(modelData.dragRowIdx, mouseOverIdx);
-    // save the new row index the user is dragging
-    modelData.dragRowIdx = mouseOverIdx;
-    // update information in rows
-    updateContent();
-    // ListBox must be repainted, or else it will display old clipped images of
-    // the old rows. This would look like GUI bug to the user otherwise.
-    repaint();
+    // user is dragging source row over another row. Move it there and save
+    // the new row index the user is dragging.
+    {
+        DRAG_PROFILE_SCOPE(swapRows);
+        record(DragSessionTrace::EventType::rowMoved, modelData.dragRowIdx, mouseOverIdx);
+        modelData.dragRowIdx = modelData.moveRow(modelData.dragRowIdx, mouseOverIdx);
+    }
+    // update information in rows. With row ids, each row component repaints
+    // itself if its content changed
+    {
+        DRAG_PROFILE_SCOPE(updateContent);
+        updateContent();
+    }
+    // Without ids, the ListBox must be repainted, or else it will display old
+    // clipped images of the old rows. This would look like GUI bug to the
+    // user otherwise.
+    if (modelData.getRowId(modelData.dragRowIdx) < 0)
+        repaint();
 }
 
 void DraggableListBox::itemDragEnter(const SourceDetails& dragSourceDetails)
 {
+    if (isForeignDrag(dragSourceDetails)) { return; }
+
+    record(DragSessionTrace::EventType::dragEnter, dragSourceDetails.localPosition.x, dragSourceDetails.localPosition.y);
     modelData.draggingOutsideContainer = false;
 }
 void DraggableListBox::itemDragExit(const SourceDetails& dragSourceDetails)
 {
+    if (isForeignDrag(dragSourceDetails)) { return; }
+
+    record(DragSessionTrace::EventType::dragExit);
     modelData.draggingOutsideContainer = true;
+    stopAutoScroll();
 }
 
-void DraggableListBox::dragOperationEnded(const DropTarget::SourceDetails& dragSourceDetails)
+void DraggableListBox::itemDropped(const SourceDetails& dragSourceDetails)
+{
+    if (isForeignDrag(dragSourceDetails))
+    {
+        acceptRowFrom(*getSourceList(dragSourceDetails),
+                      getInsertionIndexForPosition(dragSourceDetails.localPosition.x, dragSourceDetails.localPosition.y));
+        return;
+    }
+
+    record(DragSessionTrace::EventType::dropped, dragSourceDetails.localPosition.x, dragSourceDetails.localPosition.y);
+}
+
+void DraggableListBox::acceptRowFrom(DraggableListBox& source, int insertionIdx)
+{
+    auto& sourceData = source.modelData;
+    const int sourceRowIdx = sourceData.dragRowIdx;
+
+    auto payload = sourceData.extractRow(sourceRowIdx);
+
+    if (payload == nullptr)
+    {
+        // The source kept the row, so it mustn't be deleted as dragged out of
+        // the source when its drag ends over this list.
+        sourceData.draggingOutsideContainer = false;
+        return;
+    }
+
+    // The row has left the source, so its drag must no longer count as a
+    // drag-out deletion
+    sourceData.dragRowIdx = -1;
+    sourceData.draggingOutsideContainer = false;
+
+    if (insertionIdx < 0)
+        insertionIdx = modelData.size();
+
+    const bool inserted = modelData.insertRow(insertionIdx, std::move(payload));
+
+    if (!inserted)
+    {
+        // refused, so ownership goes back to the source
+        const bool restored = sourceData.insertRow(sourceRowIdx, std::move(payload));
+        jassertquiet(restored); // the source must accept its own rows back
+    }
+
+    // The source's drag only ends once the drag image has gone, so refresh it
+    // now rather than leave it showing rows it no longer has
+    source.updateContent();
+    source.repaint();
+
+    if (inserted)
+    {
+        updateContent();
+        repaint();
+    }
+}
+
+bool DraggableListBox::shouldDropTextWhenDraggedExternally(const DropTarget::SourceDetails&, juce::String& text)
+{
+    if (!interProcessDragging || modelData.dragRowIdx < 0 || pendingExternalHandle.isNotEmpty())
+        return false;
+
+    juce::MemoryOutputStream row;
+    if (!modelData.writeRowTo(modelData.dragRowIdx, row)) { return false; }
+
+    text = SharedMemoryDragChannel::publish(row.getData(), row.getDataSize());
+    if (text.isEmpty()) { return false; }
+
+    pendingExternalHandle = text;
+    pendingExternalRowIdx = modelData.dragRowIdx;
+    pendingExternalRowId = modelData.getRowId(modelData.dragRowIdx);
+    // the row is only removed if another process takes it
+    modelData.draggingOutsideContainer = false;
+    return true;
+}
+
+void DraggableListBox::externalDragFinished(const juce::String& text)
+{
+    if (text == pendingExternalHandle)
+        finishExternalDrag(false);
+}
+
+void DraggableListBox::finishExternalDrag(bool isLastCheck)
 {
-    if (modelData.draggingOutsideContainer)
+    using WithdrawResult = SharedMemoryDragChannel::WithdrawResult;
+
+    // Until the last check only look, so a receiver that handles the drop
+    // late can still take the row. The last check withdraws the row, after
+    // which no receiver can claim it, so it's safe to keep.
+    auto result = WithdrawResult::claimed;
+
+    if (isLastCheck)
+        result = SharedMemoryDragChannel::withdraw(pendingExternalHandle);
+    else if (SharedMemoryDragChannel::wasConsumed(pendingExternalHandle))
+        result = WithdrawResult::consumed;
+
+    if (result == WithdrawResult::claimed)
     {
-        modelData.deleteRow(modelData.dragRowIdx);
+        // The receiver may only handle the drop after our side of the OS drag
+        // has finished, so give it a moment before deciding nobody took it.
+        // On the last check a receiver is inserting the row right now.
+        if (!isLastCheck || ++numExternalDragRetries <= maxExternalDragRetries)
+        {
+            juce::Component::SafePointer<DraggableListBox> safeThis(this);
+            juce::Timer::callAfterDelay(isLastCheck ? 100 : 1000, [safeThis]
+            {
+                if (safeThis != nullptr)
+                    safeThis->finishExternalDrag(true);
+            });
+            return;
+        }
+
+        // Claimed but never committed or given back, so the receiver most
+        // likely died. Keeping the row may duplicate it, losing it is worse.
+        juce::Logger::writeToLog("DraggableListBox: the receiver of a dragged row never finished, keeping the row");
     }
 
-    modelData.dragRowIdx = -1;
+    settleExternalDrag(result == WithdrawResult::consumed, true);
+}
+
+void DraggableListBox::settleExternalDrag(bool rowWasTaken, bool refresh)
+{
+    if (rowWasTaken)
+    {
+        const int rowIdx = findPendingExternalRow();
+
+        if (rowIdx >= 0)
+        {
+            modelData.deleteRow(rowIdx);
+
+            // a new drag may have started in the meantime
+            if (modelData.dragRowIdx > rowIdx)
+                --modelData.dragRowIdx;
+
+            if (refresh)
+            {
+                updateContent();
+                repaint();
+            }
+        }
+    }
+
+    SharedMemoryDragChannel::release(pendingExternalHandle);
+    pendingExternalHandle = {};
+    pendingExternalRowIdx = -1;
+    pendingExternalRowId = -1;
+    numExternalDragRetries = 0;
+}
+
+int DraggableListBox::findPendingExternalRow()
+{
+    // Rows may have moved since the drag, so find the row by its id. Without
+    // ids there's no telling which row it is now, so keep it.
+    if (pendingExternalRowId < 0)
+    {
+        juce::Logger::writeToLog("DraggableListBox: a row taken by another process can't be found without row ids, keeping it");
+        return -1;
+    }
+
+    const int numRows = modelData.size();
+
+    if (isPositiveAndBelow(pendingExternalRowIdx, numRows)
+         && modelData.getRowId(pendingExternalRowIdx) == pendingExternalRowId)
+        return pendingExternalRowIdx;
+
+    for (int i = 0; i < numRows; ++i)
+        if (modelData.getRowId(i) == pendingExternalRowId)
+            return i;
+
+    return -1;
+}
+
+bool DraggableListBox::isInterestedInTextDrag(const juce::String& text)
+{
+    // a row of ours dropped back onto us is just a cancelled drag
+    return interProcessDragging && SharedMemoryDragChannel::isHandle(text) && text != pendingExternalHandle;
+}
+
+void DraggableListBox::textDropped(const juce::String& text, int x, int y)
+{
+    SharedMemoryDragChannel::Reader reader(text);
+    if (!reader.isValid() || !reader.claim()) { return; }
+
+    int insertionIdx = getInsertionIndexForPosition(x, y);
+    if (insertionIdx < 0)
+        insertionIdx = modelData.size();
+
+    juce::MemoryInputStream row(reader.getData(), reader.getSize(), false);
+
+    if (!modelData.insertRowFrom(insertionIdx, row))
+    {
+        // leave it with the sender
+        reader.unclaim();
+        return;
+    }
+
+    // tells the sender to remove its copy
+    reader.commit();
+
     updateContent();
     repaint();
 }
 
+void DraggableListBox::setAutoScrollParameters(int edgeSize, float maxPixelsPerSecond)
+{
+    autoScrollEdgeSize = jmax(0, edgeSize);
+    maxAutoScrollSpeed = jmax(0.0f, maxPixelsPerSecond);
+}
+
+DraggableListBox::MemoryUsage DraggableListBox::getMemoryUsage()
+{
+    MemoryUsage usage;
+    usage.numRows = modelData.size();
+    usage.modelBytes = modelData.getMemoryUsage();
+    usage.imageCacheBytes = getDragImageMemoryUsage();
+
+    // only the rows on screen have a component
+    auto* listViewport = getViewport();
+    const int rowHeight = jmax(1, getRowHeight());
+    const int firstRow = listViewport->getViewPositionY() / rowHeight;
+    const int lastRow = jmin(usage.numRows - 1, (listViewport->getViewPositionY() + listViewport->getViewHeight()) / rowHeight);
+
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        auto* c = getComponentForRowNumber(row);
+        if (c == nullptr) { continue; }
+
+        ++usage.numRowComponents;
+        usage.componentBytes += sizeof(DraggableListBoxItem);
+
+        // setBufferedToImage() keeps an ARGB image of the row at display resolution
+        if (c->getCachedComponentImage() != nullptr)
+        {
+            const auto scale = Component::getApproximateScaleFactorForComponent(c);
+            usage.imageCacheBytes += (size_t)(c->getWidth() * scale) * (size_t)(c->getHeight() * scale) * 4;
+        }
+    }
+
+    return usage;
+}
+
+juce::String DraggableListBox::MemoryUsage::toString() const
+{
+    juce::String s;
+    s << numRows << " rows: model " << (juce::int64)modelBytes << " bytes"
+      << ", " << numRowComponents << " row components " << (juce::int64)componentBytes << " bytes"
+      << ", image caches " << (juce::int64)imageCacheBytes << " bytes"
+      << " (" << juce::String(getBytesPerRow(), 1) << " bytes per row)";
+    return s;
+}
+
+void DraggableListBox::updateAutoScroll()
+{
+    if (modelData.dragRowIdx < 0) { return; }
+
+    const auto area = getViewport()->getBounds();
+    const int edge = jmax(1, autoScrollEdgeSize > 0 ? autoScrollEdgeSize : getRowHeight());
+    const int y = lastDragPosition.y;
+
+    float depth = 0.0f;
+    if (y < area.getY() + edge)
+        depth = -(float)(area.getY() + edge - y) / (float)edge;
+    else if (y > area.getBottom() - edge)
+        depth = (float)(y - (area.getBottom() - edge)) / (float)edge;
+
+    // ease in, so just touching the edge scrolls slowly
+    depth = jlimit(-1.0f, 1.0f, depth);
+    autoScrollVelocity = depth * std::abs(depth) * maxAutoScrollSpeed;
+
+    if (autoScrollVelocity == 0.0f)
+    {
+        stopAutoScroll();
+        return;
+    }
+
+    if (autoScrollVBlank == nullptr)
+    {
+        lastAutoScrollTime = Time::getMillisecondCounterHiRes();
+        autoScrollRemainder = 0.0;
+        autoScrollVBlank = std::make_unique<VBlankAttachment>(this, [this] { autoScrollStep(); });
+    }
+}
+
+void DraggableListBox::stopAutoScroll()
+{
+    autoScrollVBlank = nullptr;
+    autoScrollVelocity = 0.0f;
+}
+
+void DraggableListBox::autoScrollStep()
+{
+    const auto now = Time::getMillisecondCounterHiRes();
+    // a stalled frame shouldn't make the list jump
+    const auto elapsedSeconds = jmin(0.05, (now - lastAutoScrollTime) * 0.001);
+    lastAutoScrollTime = now;
+
+    autoScrollRemainder += autoScrollVelocity * elapsedSeconds;
+    const auto delta = (int)autoScrollRemainder;
+    if (delta == 0) { return; }
+    autoScrollRemainder -= delta;
+
+    scrollDuringDrag(delta);
+}
+
+void DraggableListBox::scrollDuringDrag(int deltaY)
+{
+    auto* listViewport = getViewport();
+    const auto oldY = listViewport->getViewPositionY();
+    listViewport->setViewPosition(listViewport->getViewPositionX(), oldY + deltaY);
+
+    if (listViewport->getViewPositionY() == oldY)
+    {
+        // reached the top or bottom of the list
+        autoScrollRemainder = 0.0;
+        return;
+    }
+
+    record(DragSessionTrace::EventType::autoScrolled, deltaY);
+
+    // The ListBox recycles its row components as they scroll, so give the data
+    // a chance to get the next screenful ready before it's painted.
+    const int rowHeight = jmax(1, getRowHeight());
+    const int firstVisible = listViewport->getViewPositionY() / rowHeight;
+    const int numVisible = getNumRowsOnScreen() + 1;
+    const auto ahead = deltaY > 0 ? Range<int>(firstVisible + numVisible, firstVisible + 2 * numVisible)
+                                  : Range<int>(firstVisible - numVisible, firstVisible);
+
+    modelData.rowsAboutToBecomeVisible(ahead.getIntersectionWith({ 0, modelData.size() }), deltaY > 0 ? 1 : -1);
+
+    // the mouse hasn't moved, but the row under it has
+    moveDraggedRowUnder(lastDragPosition);
+}
+
+void DraggableListBox::applyPermutation(const juce::Array<int>& newOrder)
+{
+    // checked here as well, since overrides of the data's applyPermutation()
+    // usually index their storage with newOrder directly
+    if (!DraggableListBoxSort::isPermutation(newOrder, modelData.size()))
+    {
+        jassertfalse; // newOrder must hold each row index exactly once
+        return;
+    }
+
+    // keep following the dragged row if the list is reordered mid-drag
+    if (modelData.dragRowIdx >= 0)
+        modelData.dragRowIdx = newOrder.indexOf(modelData.dragRowIdx);
+
+    modelData.applyPermutation(newOrder);
+    updateContent();
+    repaint();
+}
+
+void DraggableListBox::dragOperationStarted(const DropTarget::SourceDetails& dragSourceDetails)
+{
+    // the description is the dragged row, see DraggableListBoxItem::mouseDrag()
+    record(DragSessionTrace::EventType::dragStarted, (int)dragSourceDetails.description);
+}
+
+void DraggableListBox::dragOperationCancelled(const DropTarget::SourceDetails&)
+{
+    record(DragSessionTrace::EventType::dragCancelled);
+    dragCancelled = true;
+}
+
+void DraggableListBox::dragOperationEnded(const DropTarget::SourceDetails& dragSourceDetails)
+{
+    stopAutoScroll();
+    record(DragSessionTrace::EventType::dragEnded, modelData.draggingOutsideContainer ? 1 : 0);
+
+    const int draggedRow = modelData.dragRowIdx;
+
+    if (modelData.endDrag(dragCancelled))
+        record(DragSessionTrace::EventType::rowDeleted, draggedRow);
+
+    dragCancelled = false;
+
+    // a row handed to another list has already refreshed this one, see acceptRowFrom()
+    if (draggedRow >= 0)
+    {
+        updateContent();
+        repaint();
+    }
+}
+
 
 //==============================================================================
 
@@ -63,8 +553,8 @@ Component* DraggableListBoxModel::refreshComponentForRow(int rowNumber,
     {
         if (item == nullptr)
             item = std::make_unique<DraggableListBoxItem>(modelData, rowNumber);
-        else
-            item->rowIdx = rowNumber;
+
+        item->bindToRow(rowNumber);
     }
     return item.release();
 }
@@ -73,6 +563,19 @@ Component* DraggableListBoxModel::refreshComponentForRow(int rowNumber,
 //==============================================================================
 
 
+void DraggableListBoxItem::bindToRow(int newRowIdx)
+{
+    const auto newRowId = modelData.getRowId(newRowIdx);
+    const bool dragged = newRowIdx == modelData.dragRowIdx;
+
+    if (newRowId < 0 || newRowId != rowId || dragged != paintedAsDragged)
+        repaint();
+
+    rowIdx = newRowIdx;
+    rowId = newRowId;
+    paintedAsDragged = dragged;
+}
+
 void DraggableListBoxItem::mouseEnter(const MouseEvent&)
 {
     savedCursor = getMouseCursor();
@@ -91,9 +594,13 @@ void DraggableListBoxItem::mouseDrag(const MouseEvent& e)
     {
         if (!container->isDragAndDropActive())
         {
+            auto* list = findParentComponentOfClass<DraggableListBox>();
+            const bool toOtherLists = list != nullptr && list->isCrossListDraggingEnabled();
+
             juce::ScaledImage scaledImg (createComponentSnapshot(getLocalBounds()));
-            container->startDragging(rowIdx, this, scaledImg);
+            container->startDragging(rowIdx, this, scaledImg, toOtherLists);
             modelData.dragRowIdx = rowIdx;
+            bindToRow(rowIdx);
         }
     }
 }
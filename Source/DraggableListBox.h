@@ -1,9 +1,23 @@
 #pragma once
 #include "JuceHeader.h"
 #include "DragContainer.h"
+#include "DragProfiler.h"
+#include "DragSessionRecorder.h"
+#include "SharedMemoryDragChannel.h"
+#include "DraggableListBoxSort.h"
 
 class DraggableListBoxItem;
 
+//==============================================================================
+
+// The contents of one row while it is handed from one list's data to another.
+// Derive your own row type from this, see DraggableListBoxItemData::extractRow()
+struct DraggableListBoxRowPayload
+{
+    virtual ~DraggableListBoxRowPayload() = default;
+};
+
+
 //==============================================================================
 
 // Base class for holding all relevant row data
@@ -16,6 +30,58 @@ public:
     virtual void swapRows(int sourceRowidx, int targetRowIdx)=0;
     virtual void deleteRow(int idx) {};
 
+    // Reorders every row in one pass. newOrder[i] is the current index of the
+    // row that should end up at position i. The default follows the cycles of
+    // the permutation with swapRows(), override it if your storage can simply
+    // be rebuilt in the new order. DraggableListBox::applyPermutation() checks
+    // newOrder is a permutation of the rows before calling it.
+    virtual void applyPermutation(const juce::Array<int>& newOrder);
+
+    // Moves the row at fromIdx to toIdx, shifting the rows in between, and
+    // returns its new index. The default uses adjacent swapRows() calls so
+    // rows skipped by a fast drag or an auto-scroll keep their order.
+    virtual int moveRow(int fromIdx, int toIdx);
+
+    // Called before numRows more rows are added in bulk, see BulkRowImporter.h.
+    // Override to grow your storage once instead of row by row.
+    virtual void reserveRows(int /*numRows*/) {}
+
+    // Called while the list auto-scrolls during a drag, with the rows that
+    // are about to come into view and the direction (-1 up, 1 down). Override
+    // to warm up whatever painting those rows needs.
+    virtual void rowsAboutToBecomeVisible(juce::Range<int> /*rows*/, int /*direction*/) {}
+
+    // Optional stable identity of the row at idx (e.g. a database key), which
+    // must not change when rows are reordered. Return -1, the default, if
+    // your rows have none. With ids, a reorder only repaints the rows whose
+    // content changed instead of the whole list.
+    virtual juce::int64 getRowId(int /*idx*/) { return -1; }
+
+    // Bytes your rows take up, for DraggableListBox::getMemoryUsage(). Return
+    // 0, the default, if you don't keep track.
+    virtual size_t getMemoryUsage() { return 0; }
+
+    // Dragging rows between lists. When a row from another list is dropped
+    // on this one and canInsertRowFrom() agrees, the source's extractRow()
+    // removes the row and moves its contents into a payload, which is passed
+    // to insertRow() here. insertRow() should only move from the payload if it
+    // accepts it, otherwise the row goes back to where it came from.
+    // A cancelled drop never extracts anything, so the source keeps the row.
+    virtual std::unique_ptr<DraggableListBoxRowPayload> extractRow(int /*idx*/) { return nullptr; }
+    virtual bool canInsertRowFrom(DraggableListBoxItemData& /*source*/) { return false; }
+    virtual bool insertRow(int /*idx*/, std::unique_ptr<DraggableListBoxRowPayload>&& /*payload*/) { return false; }
+
+    // Dragging rows to another process. writeRowTo() serialises a row that is
+    // dragged out of the app, and insertRowFrom() adds one dragged in from
+    // another process, return false if that isn't possible.
+    virtual bool writeRowTo(int /*idx*/, juce::OutputStream&) { return false; }
+    virtual bool insertRowFrom(int /*idx*/, juce::InputStream&) { return false; }
+
+    // Called by the list once a drag is over. Deletes the dragged row if it
+    // was dropped outside the list and the drag wasn't cancelled, then resets
+    // the drag state. Returns true if the row was deleted.
+    bool endDrag(bool wasCancelled);
+
     int dragRowIdx = -1;
     bool draggingOutsideContainer = false;
 };
@@ -28,21 +94,127 @@ class DraggableListBox
     : public juce::ListBox
     , public DragContainer
     , public DropTarget
+    , public juce::TextDragAndDropTarget
 {
 public:
     DraggableListBox(DraggableListBoxItemData& md): modelData(md) {}
+    ~DraggableListBox() override;
 
     // DropTarget
-    bool isInterestedInDragSource(const SourceDetails&) override { return true; }
+    bool isInterestedInDragSource(const SourceDetails& dragSourceDetails) override;
     void itemDragEnter(const SourceDetails& dragSourceDetails) override;
     void itemDragExit(const SourceDetails& dragSourceDetails) override;
     void itemDragMove(const SourceDetails&) override;
-    void itemDropped(const SourceDetails& dragSourceDetails) override {}
+    void itemDropped(const SourceDetails& dragSourceDetails) override;
+
+    // Reorders all rows at once and refreshes the list a single time. Does
+    // nothing (and asserts) if newOrder isn't a permutation of the rows.
+    // See DraggableListBoxItemData::applyPermutation()
+    void applyPermutation(const juce::Array<int>& newOrder);
+
+    // Stable-sorts the rows by the key getKey(rowIdx) returns. Keys of large
+    // lists are computed in parallel, see DraggableListBoxSort.h
+    template <typename KeyFunction>
+    void sortRows(KeyFunction&& getKey)
+    {
+        applyPermutation(DraggableListBoxSort::computeStableOrder(modelData.size(),
+                                                                  std::forward<KeyFunction>(getKey)));
+    }
+
+    // While a row is dragged within edgeSize pixels of the top or bottom (0
+    // means one row height), the list scrolls once per display frame, faster
+    // the closer the mouse gets to the edge.
+    void setAutoScrollParameters(int edgeSize, float maxPixelsPerSecond);
+
+    // Lets rows be dragged out of this list onto other DraggableListBoxes.
+    // The drag image then lives on the desktop, but dragImageMove() still
+    // receives positions relative to the list the image is over.
+    void setCrossListDraggingEnabled(bool shouldBeEnabled) noexcept { crossListDragging = shouldBeEnabled; }
+    bool isCrossListDraggingEnabled() const noexcept { return crossListDragging; }
+
+    // Lets rows be dragged to and from lists in other processes, e.g. other
+    // instances of a plugin. A row dragged outside every window of the app
+    // is written to a shared-memory segment and only its handle is passed to
+    // the OS drag. The row is removed here once another process has taken it.
+    void setInterProcessDraggingEnabled(bool shouldBeEnabled) noexcept { interProcessDragging = shouldBeEnabled; }
+
+    // TextDragAndDropTarget, receives rows dragged from other processes
+    bool isInterestedInTextDrag(const juce::String& text) override;
+    void textDropped(const juce::String& text, int x, int y) override;
+
+    // Captures the drag input this list receives and the model changes it
+    // makes into the recorder, if it is recording. Pass nullptr to detach.
+    void setSessionRecorder(DragSessionRecorder* recorder) noexcept { sessionRecorder = recorder; }
+
+    // What the list costs in memory right now
+    struct MemoryUsage
+    {
+        int numRows = 0;
+        int numRowComponents = 0;
+        size_t modelBytes = 0;          // as reported by the data's getMemoryUsage()
+        size_t componentBytes = 0;      // the row components' objects, not counting your subclass' members
+        size_t imageCacheBytes = 0;     // buffered row images and the drag image
+
+        double getBytesPerRow() const noexcept
+        {
+            return numRows > 0 ? (double)(modelBytes + componentBytes + imageCacheBytes) / numRows : 0.0;
+        }
+
+        juce::String toString() const;
+    };
+
+    MemoryUsage getMemoryUsage();
 
 protected:
+    void dragOperationStarted(const DropTarget::SourceDetails& dragSourceDetails) override;
     void dragOperationEnded(const DropTarget::SourceDetails& dragSourceDetails) override;
+    void dragOperationCancelled(const DropTarget::SourceDetails& dragSourceDetails) override;
+    bool shouldDropTextWhenDraggedExternally(const DropTarget::SourceDetails&, juce::String& text) override;
+    void externalDragFinished(const juce::String& text) override;
 
     DraggableListBoxItemData& modelData;
+
+private:
+    friend class DragSessionPlayer;
+    friend class DragStressHarness;
+
+    void moveDraggedRowUnder(juce::Point<int> position);
+    void updateAutoScroll();
+    void stopAutoScroll();
+    void autoScrollStep();
+    void scrollDuringDrag(int deltaY);
+    DraggableListBox* getSourceList(const SourceDetails& dragSourceDetails) const;
+    bool isForeignDrag(const SourceDetails& dragSourceDetails) const;
+    void acceptRowFrom(DraggableListBox& source, int insertionIdx);
+    void finishExternalDrag(bool isLastCheck);
+    void settleExternalDrag(bool rowWasTaken, bool refresh);
+    int findPendingExternalRow();
+
+    void record(DragSessionTrace::EventType type, int a = 0, int b = 0)
+    {
+        if (sessionRecorder != nullptr)
+            sessionRecorder->record(type, a, b);
+    }
+
+    DragSessionRecorder* sessionRecorder = nullptr;
+    bool crossListDragging = false;
+    bool interProcessDragging = false;
+    bool dragCancelled = false;
+    juce::String pendingExternalHandle;
+    int pendingExternalRowIdx = -1;
+    juce::int64 pendingExternalRowId = -1;
+
+    // while a receiver has claimed the row, 100 ms apart
+    static constexpr int maxExternalDragRetries = 50;
+    int numExternalDragRetries = 0;
+
+    std::unique_ptr<juce::VBlankAttachment> autoScrollVBlank;
+    juce::Point<int> lastDragPosition;
+    int autoScrollEdgeSize = 0;
+    float maxAutoScrollSpeed = 3000.0f;
+    float autoScrollVelocity = 0.0f;
+    double autoScrollRemainder = 0.0;
+    double lastAutoScrollTime = 0.0;
 };
 
 
@@ -77,14 +249,21 @@ public:
     // as that class should have all your data for all rows
     void paint(juce::Graphics& g) override
     {
+        DRAG_PROFILE_SCOPE(rowPaint);
         modelData.paintRow(this, rowIdx, g, getLocalBounds());
     }
     void mouseEnter(const juce::MouseEvent&) override;
     void mouseExit(const juce::MouseEvent&) override;
     void mouseDrag(const juce::MouseEvent&) override;
 
+    // Shows newRowIdx from now on, repainting only if the row id says the
+    // content is different (or there are no row ids)
+    void bindToRow(int newRowIdx);
+
     int rowIdx;
 protected:
     DraggableListBoxItemData& modelData;
     juce::MouseCursor savedCursor;
+    juce::int64 rowId = -1;
+    bool paintedAsDragged = false;
 };
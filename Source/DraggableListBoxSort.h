@@ -0,0 +1,106 @@
+#pragma once
+#include "JuceHeader.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//==============================================================================
+
+// Helpers for computing a whole new row order in one go. The result is meant to
+// be handed to DraggableListBox::applyPermutation() so a sort costs one
+// reorder and one refresh instead of thousands of swapRows() calls.
+namespace DraggableListBoxSort
+{
+    // True if order holds every index in [0, numRows) exactly once, which is
+    // what applyPermutation() needs. Anything else would swap rows out of
+    // range or never finish a cycle.
+    inline bool isPermutation(const juce::Array<int>& order, int numRows)
+    {
+        if (order.size() != numRows)
+            return false;
+
+        std::vector<bool> seen((size_t) juce::jmax(0, numRows), false);
+
+        for (auto idx : order)
+        {
+            if (!juce::isPositiveAndBelow(idx, numRows) || seen[(size_t) idx])
+                return false;
+
+            seen[(size_t) idx] = true;
+        }
+
+        return true;
+    }
+
+    // Below this many rows the keys are computed on the calling thread, as
+    // starting the workers would cost more than it saves.
+    constexpr int parallelKeyThreshold = 16384;
+
+    // Returns the stable order of rows [0, numRows) sorted by getKey(rowIdx).
+    // order[i] is the current index of the row that belongs at position i.
+    // Keys are computed in parallel for large lists, so getKey must be safe to
+    // call from several threads at once and should only read row data.
+    template <typename KeyFunction, typename Compare = std::less<>>
+    juce::Array<int> computeStableOrder(int numRows, KeyFunction&& getKey, Compare compare = {})
+    {
+        using KeyType = std::decay_t<decltype(getKey(0))>;
+
+        // std::vector<bool> packs its elements into shared words, so threads
+        // writing neighbouring keys would race. Store bools as chars instead.
+        using StoredKeyType = std::conditional_t<std::is_same<KeyType, bool>::value, char, KeyType>;
+        std::vector<StoredKeyType> keys((size_t) juce::jmax(0, numRows));
+
+        auto computeKeys = [&keys, &getKey](int start, int end)
+        {
+            for (int i = start; i < end; ++i)
+                keys[(size_t) i] = getKey(i);
+        };
+
+        const int numThreads = numRows < parallelKeyThreshold ? 1
+                                                              : juce::jmax(1, juce::SystemStats::getNumCpus());
+
+        if (numThreads == 1)
+        {
+            computeKeys(0, numRows);
+        }
+        else
+        {
+            const int chunkSize = (numRows + numThreads - 1) / numThreads;
+            std::vector<std::thread> workers;
+            workers.reserve((size_t) numThreads - 1);
+
+            for (int t = 1; t < numThreads; ++t)
+                workers.emplace_back(computeKeys,
+                                     juce::jmin(numRows, t * chunkSize),
+                                     juce::jmin(numRows, (t + 1) * chunkSize));
+
+            // the calling thread takes the first chunk itself
+            computeKeys(0, juce::jmin(numRows, chunkSize));
+
+            for (auto& worker : workers)
+                worker.join();
+        }
+
+        juce::Array<int> order;
+        order.ensureStorageAllocated(numRows);
+        for (int i = 0; i < numRows; ++i)
+            order.add(i);
+
+        auto keyOf = [&keys](int rowIdx) -> decltype(auto)
+        {
+            if constexpr (std::is_same<KeyType, bool>::value)
+                return keys[(size_t) rowIdx] != 0;
+            else
+                return static_cast<const KeyType&>(keys[(size_t) rowIdx]);
+        };
+
+        std::stable_sort(order.begin(), order.end(), [&keyOf, &compare](int a, int b)
+        {
+            return compare(keyOf(a), keyOf(b));
+        });
+
+        return order;
+    }
+}
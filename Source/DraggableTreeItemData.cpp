@@ -0,0 +1,314 @@
+#include "DraggableTreeItemData.h"
+
+
+//==============================================================================
+
+
+DraggableTreeItemData::~DraggableTreeItemData()
+{
+    deleteRows(root);
+}
+
+DraggableTreeItemData::Row* DraggableTreeItemData::createRow(std::unique_ptr<DraggableTreeNode> node, int depth)
+{
+    auto* r = new Row();
+    r->node = std::move(node);
+    r->priority = (juce::uint32) random.nextInt();
+    r->depth = r->minDepth = depth;
+    return r;
+}
+
+void DraggableTreeItemData::deleteRows(Row* r)
+{
+    if (r == nullptr) { return; }
+
+    deleteRows(r->left);
+    deleteRows(r->right);
+    deleteRows(r->hidden);
+    delete r;
+}
+
+void DraggableTreeItemData::addDepth(Row* r, int delta) noexcept
+{
+    if (r == nullptr || delta == 0) { return; }
+
+    r->depth += delta;
+    r->minDepth += delta;
+    r->pendingDepthChange += delta;
+}
+
+void DraggableTreeItemData::pushDown(Row* r) noexcept
+{
+    if (r->pendingDepthChange != 0)
+    {
+        addDepth(r->left, r->pendingDepthChange);
+        addDepth(r->right, r->pendingDepthChange);
+        r->pendingDepthChange = 0;
+    }
+}
+
+void DraggableTreeItemData::update(Row* r) noexcept
+{
+    r->count = 1 + countOf(r->left) + countOf(r->right);
+    r->minDepth = r->depth;
+
+    if (r->left != nullptr)  r->minDepth = juce::jmin(r->minDepth, r->left->minDepth);
+    if (r->right != nullptr) r->minDepth = juce::jmin(r->minDepth, r->right->minDepth);
+}
+
+void DraggableTreeItemData::split(Row* r, int numLeft, Row*& left, Row*& right)
+{
+    if (r == nullptr)
+    {
+        left = right = nullptr;
+        return;
+    }
+
+    pushDown(r);
+
+    if (countOf(r->left) < numLeft)
+    {
+        split(r->right, numLeft - countOf(r->left) - 1, r->right, right);
+        left = r;
+    }
+    else
+    {
+        split(r->left, numLeft, left, r->left);
+        right = r;
+    }
+
+    update(r);
+}
+
+DraggableTreeItemData::Row* DraggableTreeItemData::merge(Row* left, Row* right)
+{
+    if (left == nullptr)  { return right; }
+    if (right == nullptr) { return left; }
+
+    if (left->priority > right->priority)
+    {
+        pushDown(left);
+        left->right = merge(left->right, right);
+        update(left);
+        return left;
+    }
+
+    pushDown(right);
+    right->left = merge(left, right->left);
+    update(right);
+    return right;
+}
+
+DraggableTreeItemData::Row* DraggableTreeItemData::getRowAt(Row* r, int idx)
+{
+    while (r != nullptr)
+    {
+        pushDown(r);
+        const int numLeft = countOf(r->left);
+
+        if (idx < numLeft)
+            r = r->left;
+        else if (idx == numLeft)
+            return r;
+        else
+        {
+            idx -= numLeft + 1;
+            r = r->right;
+        }
+    }
+
+    return nullptr;
+}
+
+// Returns countOf(r) if no row is that shallow
+int DraggableTreeItemData::findFirstWithDepthAtMost(Row* r, int depth)
+{
+    int offset = 0;
+
+    while (r != nullptr)
+    {
+        pushDown(r);
+
+        if (r->left != nullptr && r->left->minDepth <= depth)
+        {
+            r = r->left;
+        }
+        else
+        {
+            offset += countOf(r->left);
+
+            if (r->depth <= depth)
+                return offset;
+
+            ++offset;
+            r = r->right;
+        }
+    }
+
+    return offset;
+}
+
+DraggableTreeItemData::Row* DraggableTreeItemData::getRow(int rowIdx)
+{
+    if (!juce::isPositiveAndBelow(rowIdx, countOf(root))) { return nullptr; }
+    return getRowAt(root, rowIdx);
+}
+
+
+//==============================================================================
+
+
+void DraggableTreeItemData::addRootNode(std::unique_ptr<DraggableTreeNode> node)
+{
+    root = merge(root, createRow(std::move(node), 0));
+}
+
+DraggableTreeNode* DraggableTreeItemData::getNode(int rowIdx)
+{
+    auto* r = getRow(rowIdx);
+    return r != nullptr ? r->node.get() : nullptr;
+}
+
+int DraggableTreeItemData::getDepth(int rowIdx)
+{
+    auto* r = getRow(rowIdx);
+    return r != nullptr ? r->depth : 0;
+}
+
+bool DraggableTreeItemData::isExpanded(int rowIdx)
+{
+    auto* r = getRow(rowIdx);
+    return r != nullptr && r->expanded;
+}
+
+int DraggableTreeItemData::getNumRowsInSubtree(int rowIdx)
+{
+    auto* r = getRow(rowIdx);
+    if (r == nullptr) { return 0; }
+
+    // the subtree ends at the next row that isn't any deeper
+    Row *before, *after;
+    split(root, rowIdx + 1, before, after);
+    const int numDescendants = findFirstWithDepthAtMost(after, r->depth);
+    root = merge(before, after);
+
+    return 1 + numDescendants;
+}
+
+void DraggableTreeItemData::setExpanded(int rowIdx, bool shouldBeExpanded)
+{
+    auto* r = getRow(rowIdx);
+    if (r == nullptr || r->expanded == shouldBeExpanded) { return; }
+
+    if (shouldBeExpanded)
+    {
+        if (!r->childrenCreated)
+        {
+            r->childrenCreated = true;
+
+            for (auto& child : r->node->createChildren())
+                r->hidden = merge(r->hidden, createRow(std::move(child), 1));
+        }
+
+        Row *before, *after;
+        split(root, rowIdx + 1, before, after);
+        addDepth(r->hidden, r->depth);
+        root = merge(merge(before, r->hidden), after);
+        r->hidden = nullptr;
+    }
+    else
+    {
+        const int numRows = getNumRowsInSubtree(rowIdx);
+
+        Row *before, *descendants, *after;
+        split(root, rowIdx + 1, before, after);
+        split(after, numRows - 1, descendants, after);
+        addDepth(descendants, -r->depth);
+        r->hidden = descendants;
+        root = merge(before, after);
+    }
+
+    r->expanded = shouldBeExpanded;
+}
+
+
+//==============================================================================
+
+
+void DraggableTreeItemData::paintRow(DraggableListBoxItem* item, int rowIdx, juce::Graphics& g, juce::Rectangle<int> bounds)
+{
+    if (auto* r = getRow(rowIdx))
+        paintNode(item, *r->node, r->depth, r->expanded, g, bounds);
+}
+
+int DraggableTreeItemData::size()
+{
+    return countOf(root);
+}
+
+int DraggableTreeItemData::moveRow(int fromIdx, int toIdx)
+{
+    const int numRows = countOf(root);
+    if (fromIdx == toIdx || !juce::isPositiveAndBelow(fromIdx, numRows) || !juce::isPositiveAndBelow(toIdx, numRows))
+        return fromIdx;
+
+    // a node can't be moved into its own subtree
+    const int subtreeSize = getNumRowsInSubtree(fromIdx);
+    if (toIdx > fromIdx && toIdx < fromIdx + subtreeSize) { return fromIdx; }
+
+    Row *before, *subtree, *after;
+    split(root, fromIdx, before, after);
+    split(after, subtreeSize, subtree, after);
+    auto* rest = merge(before, after);
+
+    // moving down, the subtree goes below the row at toIdx
+    const int insertIdx = toIdx < fromIdx ? toIdx : toIdx - subtreeSize + 1;
+
+    // valid depths go from the row below (which mustn't become our child) to
+    // one deeper than the row above if that is expanded (as its first child)
+    int minDepth = 0, maxDepth = 0;
+
+    if (insertIdx < countOf(rest))
+        minDepth = getDepthOfRowAt(rest, insertIdx);
+
+    if (insertIdx > 0)
+    {
+        auto* above = getRowAt(rest, insertIdx - 1);
+        maxDepth = above->depth + (above->expanded ? 1 : 0);
+    }
+
+    const int depth = getDepthOfRowAt(subtree, 0);
+    addDepth(subtree, juce::jlimit(minDepth, maxDepth, depth) - depth);
+
+    split(rest, insertIdx, before, after);
+    root = merge(merge(before, subtree), after);
+    return insertIdx;
+}
+
+void DraggableTreeItemData::deleteRow(int idx)
+{
+    const int numRows = getNumRowsInSubtree(idx);
+    if (numRows == 0) { return; }
+
+    Row *before, *subtree, *after;
+    split(root, idx, before, after);
+    split(after, numRows, subtree, after);
+    root = merge(before, after);
+    deleteRows(subtree);
+}
+
+void DraggableTreeItemData::swapRows(int rowIdx1, int rowIdx2)
+{
+    auto* r1 = getRow(rowIdx1);
+    auto* r2 = getRow(rowIdx2);
+    if (r1 == nullptr || r2 == nullptr || r1 == r2) { return; }
+
+    // an expanded node's children would stay behind
+    jassert(!r1->expanded && !r2->expanded);
+
+    // the hidden rows are relative to their node, so they move as they are
+    std::swap(r1->node, r2->node);
+    std::swap(r1->hidden, r2->hidden);
+    std::swap(r1->expanded, r2->expanded);
+    std::swap(r1->childrenCreated, r2->childrenCreated);
+}
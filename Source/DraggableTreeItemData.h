@@ -0,0 +1,106 @@
+#pragma once
+#include "JuceHeader.h"
+#include "DraggableListBox.h"
+#include <vector>
+
+//==============================================================================
+
+// One node of a DraggableTreeItemData. Derive your own node type to hold the
+// content, like you would a juce::TreeViewItem.
+class DraggableTreeNode
+{
+public:
+    virtual ~DraggableTreeNode() = default;
+
+    // Whether expanding this node might show any children
+    virtual bool mightHaveChildren() const { return false; }
+
+    // Called the first time the node is expanded, return its children in
+    // order. Their own children aren't created until they are expanded in turn.
+    virtual std::vector<std::unique_ptr<DraggableTreeNode>> createChildren() { return {}; }
+};
+
+
+//==============================================================================
+
+
+// Row data for a tree shown in a DraggableListBox. Only the rows of expanded
+// nodes are in the list, and a node's children are created lazily when it is
+// first expanded. Collapsing a node puts its rows away with it rather than
+// deleting them.
+//
+// The visible rows are kept in an implicit treap, so looking up, moving,
+// expanding, collapsing or deleting a node is O(log n) however many
+// descendants it has. Dragging a row moves it together with its subtree. The
+// moved node keeps its depth where it can, otherwise it takes the nearest
+// depth that is valid where it was dropped, e.g. it becomes the first child
+// of the expanded node above it.
+class DraggableTreeItemData : public DraggableListBoxItemData
+{
+public:
+    DraggableTreeItemData() = default;
+    ~DraggableTreeItemData() override;
+
+    virtual void paintNode(DraggableListBoxItem* item, DraggableTreeNode& node, int depth, bool isExpanded,
+                           juce::Graphics& g, juce::Rectangle<int> bounds) = 0;
+
+    // Adds a collapsed node at the end of the top level
+    void addRootNode(std::unique_ptr<DraggableTreeNode> node);
+
+    DraggableTreeNode* getNode(int rowIdx);
+    int getDepth(int rowIdx);
+    bool isExpanded(int rowIdx);
+
+    // Shows or hides the children of the node at rowIdx. Call updateContent()
+    // on the list afterwards. Don't call it during a drag, it shifts the rows.
+    void setExpanded(int rowIdx, bool shouldBeExpanded);
+
+    // The number of rows the node at rowIdx occupies, itself included
+    int getNumRowsInSubtree(int rowIdx);
+
+    // DraggableListBoxItemData
+    void paintRow(DraggableListBoxItem* item, int rowIdx, juce::Graphics& g, juce::Rectangle<int> bounds) override;
+    int size() override;
+    int moveRow(int fromIdx, int toIdx) override;
+    void deleteRow(int idx) override;
+
+    // Swaps two collapsed rows, each with its hidden subtree. Only meant for
+    // sorting siblings, drags use moveRow().
+    void swapRows(int rowIdx1, int rowIdx2) override;
+
+private:
+    struct Row
+    {
+        std::unique_ptr<DraggableTreeNode> node;
+        Row* left = nullptr;
+        Row* right = nullptr;
+        Row* hidden = nullptr;          // rows of a collapsed subtree, depths relative to this one
+        juce::uint32 priority = 0;
+        int count = 1;                  // rows in this treap subtree
+        int depth = 0;
+        int minDepth = 0;               // smallest depth in this treap subtree
+        int pendingDepthChange = 0;     // still to be added to both children
+        bool expanded = false;
+        bool childrenCreated = false;
+    };
+
+    Row* createRow(std::unique_ptr<DraggableTreeNode> node, int depth);
+    static void deleteRows(Row* r);
+
+    static int countOf(const Row* r) noexcept { return r != nullptr ? r->count : 0; }
+    static void addDepth(Row* r, int delta) noexcept;
+    static void pushDown(Row* r) noexcept;
+    static void update(Row* r) noexcept;
+    static void split(Row* r, int numLeft, Row*& left, Row*& right);
+    static Row* merge(Row* left, Row* right);
+    static Row* getRowAt(Row* r, int idx);
+    static int findFirstWithDepthAtMost(Row* r, int depth);
+
+    Row* getRow(int rowIdx);
+    int getDepthOfRowAt(Row* r, int idx) { return getRowAt(r, idx)->depth; }
+
+    Row* root = nullptr;
+    juce::Random random;
+
+    JUCE_DECLARE_NON_COPYABLE(DraggableTreeItemData)
+};
@@ -3,6 +3,7 @@
 MainContentComponent::MainContentComponent()
     : listBoxModel(itemData)
     , listBox(itemData)
+    , importer(listBox, itemData, [this](std::vector<int>& ids) { itemData.addItemsAtEnd(ids); })
 {
     itemData.addItemAtEnd();
     itemData.addItemAtEnd();
@@ -16,9 +17,80 @@ MainContentComponent::MainContentComponent()
     };
     addAndMakeVisible(addBtn);
 
+    sortBtn.setButtonText("Sort");
+    sortBtn.onClick = [this]()
+    {
+        listBox.sortRows([this](int rowIdx) { return itemData.rowIds.getUnchecked(rowIdx); });
+    };
+    addAndMakeVisible(sortBtn);
+
+    importBtn.setButtonText("Import 1M");
+    importBtn.onClick = [this]()
+    {
+        int numItems = 1000000;
+        const int firstId = itemData.allocateIds(numItems);
+
+        importBtn.setEnabled(false);
+        statusLabel.setText("Importing " + String(numItems) + " rows...", dontSendNotification);
+        importer.start(numItems, [firstId, numItems](BulkRowImporter<int>& imp)
+        {
+            // stands in for reading a session file
+            const int chunkSize = 4096;
+
+            for (int start = 0; start < numItems; start += chunkSize)
+            {
+                std::vector<int> ids;
+                for (int i = start; i < jmin(numItems, start + chunkSize); ++i)
+                    ids.push_back(firstId + i);
+
+                if (!imp.addRows(std::move(ids))) { return; }
+            }
+        });
+    };
+    importer.onFinished = [this]()
+    {
+        String msg;
+        msg << "First rows shown after " << String(importer.getMillisecondsToFirstFrame(), 1) << " ms, "
+            << itemData.size() << " rows after " << String(importer.getTotalMilliseconds(), 1) << " ms";
+
+        msg << newLine << listBox.getMemoryUsage().toString();
+
+        statusLabel.setText(msg, dontSendNotification);
+        DBG(msg);
+        importBtn.setEnabled(true);
+    };
+    addAndMakeVisible(importBtn);
+
+    benchmarkBtn.setButtonText("Benchmark");
+    benchmarkBtn.onClick = []()
+    {
+        AlertWindow::showMessageBoxAsync(MessageBoxIconType::InfoIcon, "Benchmark", runBenchmarks());
+    };
+    addAndMakeVisible(benchmarkBtn);
+
+    stressTestBtn.setButtonText("Stress test");
+    stressTestBtn.onClick = []()
+    {
+        const auto result = runStressTest();
+
+        // fail loudly in debug builds
+        jassert(result.wasOk());
+
+        AlertWindow::showMessageBoxAsync(result.wasOk() ? MessageBoxIconType::InfoIcon : MessageBoxIconType::WarningIcon,
+                                         "Stress test", result.wasOk() ? "Passed" : result.getErrorMessage());
+    };
+    addAndMakeVisible(stressTestBtn);
+
+    statusLabel.setMinimumHorizontalScale(0.5f);
+    addAndMakeVisible(statusLabel);
+
     listBox.setModel(&listBoxModel);
     listBox.setRowHeight(40);
     addAndMakeVisible(listBox);
+
+   #if DRAGLISTBOX_ENABLE_PROFILING
+    addAndMakeVisible(profilerOverlay);
+   #endif
     setSize (600, 400);
 }
 
@@ -32,7 +104,90 @@ void MainContentComponent::resized()
     auto area = getLocalBounds().reduced(20);
     auto row = area.removeFromTop(24);
     addBtn.setBounds(row.removeFromRight(100));
+    row.removeFromRight(6);
+    sortBtn.setBounds(row.removeFromRight(100));
+    row.removeFromRight(6);
+    importBtn.setBounds(row.removeFromRight(100));
+    row.removeFromRight(6);
+    benchmarkBtn.setBounds(row.removeFromRight(100));
+    row.removeFromRight(6);
+    stressTestBtn.setBounds(row.removeFromRight(100));
 
+    area.removeFromTop(6);
+    statusLabel.setBounds(area.removeFromTop(36));
     area.removeFromTop(6);
     listBox.setBounds(area);
+
+   #if DRAGLISTBOX_ENABLE_PROFILING
+    profilerOverlay.setTopLeftPosition(area.getRight() - profilerOverlay.getWidth(),
+                                       area.getBottom() - profilerOverlay.getHeight());
+   #endif
+}
+
+// Times the operations that matter for large lists on this machine. Runs on
+// the message thread, so the window doesn't respond until it's done.
+String MainContentComponent::runBenchmarks()
+{
+    String report;
+
+    for (auto numRows : { 100000, 1000000 })
+    {
+        MyListBoxItemData data;
+        data.reserveRows(numRows);
+
+        std::vector<int> ids((size_t) numRows);
+        const int firstId = data.allocateIds(numRows);
+        for (int i = 0; i < numRows; ++i)
+            ids[(size_t) i] = firstId + i;
+
+        data.addItemsAtEnd(ids);
+
+        DraggableListBoxModel model(data);
+        MyListBox list(data);
+        list.setModel(&model);
+        list.setRowHeight(40);
+        list.setSize(400, 400);
+
+        // reversing moves every row
+        const auto start = Time::getMillisecondCounterHiRes();
+        list.sortRows([&data](int rowIdx) { return -data.rowIds.getUnchecked(rowIdx); });
+        const auto elapsed = Time::getMillisecondCounterHiRes() - start;
+
+        report << "Sort " << numRows << " rows: " << String(elapsed, 1) << " ms" << newLine;
+    }
+
+    report << newLine << "Shared-memory transfer:" << newLine;
+
+    for (size_t numBytes : { (size_t) 1024, (size_t) 1 << 20, (size_t) 16 << 20 })
+        report << SharedMemoryDragChannel::measureLatency(numBytes, 20).toString() << newLine;
+
+    return report;
+}
+
+// Runs DragStressHarness over the example's data with a fixed seed, so a
+// failure can be reproduced exactly
+Result MainContentComponent::runStressTest()
+{
+    MyListBoxItemData data;
+    DraggableListBoxModel model(data);
+    MyListBox list(data);
+    list.setModel(&model);
+    list.setRowHeight(40);
+    list.setSize(400, 400);
+
+    DragStressHarness harness(list, [&data](int numRows)
+    {
+        std::vector<int> ids((size_t) numRows);
+        const int firstId = data.allocateIds(numRows);
+        for (int i = 0; i < numRows; ++i)
+            ids[(size_t) i] = firstId + i;
+
+        data.addItemsAtEnd(ids);
+    });
+
+    DragStressHarness::Options options;
+    options.seed = 0x5eed;
+    options.numSteps = 200000;
+
+    return harness.run(options);
 }
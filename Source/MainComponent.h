@@ -1,6 +1,8 @@
 #pragma once
 #include "JuceHeader.h"
 #include "MyListComponent.h"
+#include "BulkRowImporter.h"
+#include "DragStressHarness.h"
 
 class MainContentComponent   : public Component
 {
@@ -13,10 +15,23 @@ public:
     
 private:
     TextButton addBtn;
+    TextButton sortBtn;
+    TextButton importBtn;
+    TextButton benchmarkBtn;
+    TextButton stressTestBtn;
+    Label statusLabel;
 
     MyListBoxItemData itemData;
     DraggableListBoxModel listBoxModel;
     MyListBox listBox;
+    BulkRowImporter<int> importer;
+
+    static String runBenchmarks();
+    static Result runStressTest();
+
+   #if DRAGLISTBOX_ENABLE_PROFILING
+    DragProfilerOverlay profilerOverlay;
+   #endif
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
 };
@@ -31,12 +31,104 @@ public:
     // OPTIONAL. See item 5. in the README
     void deleteRow(int idx) override { rowIds.remove(idx); };
 
+    // OPTIONAL. See item 13. in the README
+    struct RowPayload : public DraggableListBoxRowPayload
+    {
+        const MyListBoxItemData* source = nullptr;
+        int id = 0;     // only unique within the source
+    };
+
+    std::unique_ptr<DraggableListBoxRowPayload> extractRow(int idx) override
+    {
+        if (!isPositiveAndBelow(idx, rowIds.size()))
+            return nullptr;
+
+        auto payload = std::make_unique<RowPayload>();
+        payload->source = this;
+        payload->id = rowIds.removeAndReturn(idx);
+        return payload;
+    }
+
+    bool canInsertRowFrom(DraggableListBoxItemData& source) override
+    {
+        return dynamic_cast<MyListBoxItemData*>(&source) != nullptr;
+    }
+
+    bool insertRow(int idx, std::unique_ptr<DraggableListBoxRowPayload>&& payload) override
+    {
+        auto* row = dynamic_cast<RowPayload*>(payload.get());
+        if (row == nullptr) { return false; }
+
+        // every list numbers its rows from 0, so a row from another list
+        // gets a new id here to keep them unique
+        rowIds.insert(idx, row->source == this ? row->id : allocateIds(1));
+        payload.reset();
+        return true;
+    }
+
+    // OPTIONAL. See item 14. in the README
+    bool writeRowTo(int idx, juce::OutputStream& out) override
+    {
+        return isPositiveAndBelow(idx, rowIds.size()) && out.writeInt(rowIds.getUnchecked(idx));
+    }
+
+    bool insertRowFrom(int idx, juce::InputStream& in) override
+    {
+        if (in.getNumBytesRemaining() < (juce::int64) sizeof(int))
+            return false;
+
+        // the sender's id is only unique in the sender's list
+        in.readInt();
+        rowIds.insert(idx, allocateIds(1));
+        return true;
+    }
+
+    // OPTIONAL. Moving in one go is cheaper than the default adjacent swaps
+    int moveRow(int fromIdx, int toIdx) override
+    {
+        rowIds.move(fromIdx, toIdx);
+        return toIdx;
+    }
+
+    // OPTIONAL. See item 16. in the README
+    juce::int64 getRowId(int idx) override { return rowIds[idx]; }
+
+    // OPTIONAL. See item 20. in the README
+    // counts the allocated storage, which is more than size() after reserveRows()
+    size_t getMemoryUsage() override { return sizeof(*this) + (size_t)rowIds.getNumAllocated() * sizeof(int); }
+
+    // OPTIONAL. See item 7. in the README
+    void applyPermutation(const juce::Array<int>& newOrder) override
+    {
+        juce::Array<int> reordered;
+        reordered.ensureStorageAllocated(newOrder.size());
+
+        for (auto idx : newOrder)
+            reordered.add(rowIds.getUnchecked(idx));
+
+        rowIds.swapWith(reordered);
+    }
+
     void addItemAtEnd()
     {
         rowIds.add(idCounter);
         idCounter++;
     };
 
+    // OPTIONAL. See item 18. in the README
+    void reserveRows(int numRows) override { rowIds.ensureStorageAllocated(rowIds.size() + numRows); }
+
+    // Hands out numIds unused ids for rows that will be added in bulk, and
+    // returns the first one
+    int allocateIds(int numIds)
+    {
+        const int firstId = idCounter;
+        idCounter += numIds;
+        return firstId;
+    }
+
+    void addItemsAtEnd(const std::vector<int>& ids) { rowIds.addArray(ids.data(), (int)ids.size()); }
+
     // Not required, just something I'm adding for confirmation of correct order after DnD.
     // This is an example of an operation on the entire list.
     /*
@@ -0,0 +1,398 @@
+#pragma once
+#include "JuceHeader.h"
+#include "DraggableListBox.h"
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//==============================================================================
+
+// Backing store for a PagedListBoxItemData, e.g. a preset library on disk.
+// loadRows() is called on a background thread while the other functions are
+// called on the message thread, so implementations must make them safe to run
+// concurrently.
+template <typename RowType>
+class PagedRowSource
+{
+public:
+    virtual ~PagedRowSource() = default;
+
+    // Called on the loader thread. Returns rows [startRow, startRow + numRows).
+    virtual std::vector<RowType> loadRows(int startRow, int numRows) = 0;
+
+    // Called on the message thread, these should not touch the disk.
+    virtual int getNumRows() = 0;
+    virtual void swapRows(int sourceRowIdx, int targetRowIdx) = 0;
+    virtual void deleteRow(int idx) {}
+
+    // Bytes a loaded row takes up in memory, for the byte cap set with
+    // PagedListBoxItemData::setMaxResidentBytes(). Called on either thread,
+    // so it should only look at the row. Override it if your rows own heap
+    // memory, e.g. strings or images.
+    virtual size_t getRowBytes(const RowType&) { return sizeof(RowType); }
+};
+
+
+//==============================================================================
+
+
+// Row data that only keeps the pages of rows around the viewport in memory.
+// Missing pages are loaded on a worker thread, and rows whose page isn't
+// loaded yet are painted as placeholders, so painting never waits for I/O.
+// Pages are prefetched around every painted row, further ahead in the
+// direction the dragged row is moving, and the least recently painted pages
+// are evicted once more than maxPagesInMemory are held, or once the rows take
+// up more than the byte cap set with setMaxResidentBytes().
+//
+// Assign onPagesLoaded to repaint your list when new rows arrive.
+template <typename RowType>
+class PagedListBoxItemData
+    : public DraggableListBoxItemData
+    , private juce::AsyncUpdater
+{
+public:
+    PagedListBoxItemData(PagedRowSource<RowType>& rowSource, int numRowsPerPage = 256, int maxPagesInMemory = 64)
+        : source(rowSource)
+        , rowsPerPage(juce::jmax(1, numRowsPerPage))
+        , maxResidentPages(juce::jmax(1, maxPagesInMemory))
+    {
+        loader.startThread();
+    }
+
+    ~PagedListBoxItemData() override
+    {
+        loader.stopThread(-1);
+        cancelPendingUpdate();
+    }
+
+    virtual void paintLoadedRow(DraggableListBoxItem*, int rowIdx, const RowType& row,
+                                juce::Graphics& g, juce::Rectangle<int> bounds) = 0;
+
+    virtual void paintPlaceholderRow(DraggableListBoxItem*, int /*rowIdx*/,
+                                     juce::Graphics& g, juce::Rectangle<int> bounds)
+    {
+        g.fillAll(juce::Colours::lightgrey.withAlpha(0.4f));
+        g.setColour(juce::Colours::grey);
+        g.drawRect(bounds);
+    }
+
+    void paintRow(DraggableListBoxItem* item, int rowIdx, juce::Graphics& g, juce::Rectangle<int> bounds) override
+    {
+        prefetchRows({ rowIdx, rowIdx + 1 }, dragRowIdx >= 0 ? dragDirection : 0);
+
+        if (auto* row = findLoadedRow(rowIdx))
+            paintLoadedRow(item, rowIdx, *row, g, bounds);
+        else
+            paintPlaceholderRow(item, rowIdx, g, bounds);
+    }
+
+    int size() override { return source.getNumRows(); }
+
+    void swapRows(int sourceRowIdx, int targetRowIdx) override
+    {
+        source.swapRows(sourceRowIdx, targetRowIdx);
+
+        if (sourceRowIdx == dragRowIdx)
+            dragDirection = targetRowIdx > sourceRowIdx ? 1 : -1;
+
+        auto* a = findLoadedRow(sourceRowIdx);
+        auto* b = findLoadedRow(targetRowIdx);
+        const int pageA = getPageForRow(sourceRowIdx);
+        const int pageB = getPageForRow(targetRowIdx);
+
+        if (a != nullptr && b != nullptr)
+        {
+            if (pageA != pageB)
+            {
+                const auto bytesA = source.getRowBytes(*a);
+                const auto bytesB = source.getRowBytes(*b);
+                residentPages[pageA].bytes += bytesB - bytesA;
+                residentPages[pageB].bytes += bytesA - bytesB;
+            }
+
+            std::swap(*a, *b);
+        }
+        else if (a != nullptr)
+        {
+            erasePage(residentPages.find(pageA));
+        }
+        else if (b != nullptr)
+        {
+            erasePage(residentPages.find(pageB));
+        }
+
+        // a load of either page that's already in flight has read stale rows
+        invalidatePendingLoad(getPageForRow(sourceRowIdx));
+        invalidatePendingLoad(getPageForRow(targetRowIdx));
+    }
+
+    void deleteRow(int idx) override
+    {
+        source.deleteRow(idx);
+
+        // every row after idx has shifted, so drop those pages and any loads
+        // that are still in flight
+        const int firstStalePage = getPageForRow(idx);
+
+        for (auto it = residentPages.begin(); it != residentPages.end();)
+            it = it->first >= firstStalePage ? erasePage(it) : std::next(it);
+
+        ++structureVersion;
+        pendingPages.clear();
+        const juce::ScopedLock sl(lock);
+        requests.clear();
+    }
+
+    // Makes sure the pages covering rows are loaded or on their way, plus
+    // prefetchDistance pages either side. A non-zero direction (e.g. from a
+    // drag or auto-scroll) doubles the prefetch that way and skips the other.
+    void prefetchRows(juce::Range<int> rows, int direction)
+    {
+        if (rows.isEmpty()) { return; }
+
+        int firstPage = getPageForRow(rows.getStart());
+        int lastPage = getPageForRow(rows.getEnd() - 1);
+
+        if (direction >= 0) lastPage += direction > 0 ? 2 * prefetchDistance : prefetchDistance;
+        if (direction <= 0) firstPage -= direction < 0 ? 2 * prefetchDistance : prefetchDistance;
+
+        const int numPages = (size() + rowsPerPage - 1) / rowsPerPage;
+        firstPage = juce::jmax(0, firstPage);
+        lastPage = juce::jmin(numPages - 1, lastPage);
+
+        for (int page = firstPage; page <= lastPage; ++page)
+            requestPage(page);
+    }
+
+    void rowsAboutToBecomeVisible(juce::Range<int> rows, int direction) override
+    {
+        prefetchRows(rows, direction);
+    }
+
+    void setPrefetchDistance(int numPages) { prefetchDistance = juce::jmax(0, numPages); }
+
+    // Also evicts pages while the loaded rows take up more than maxBytes, as
+    // reported by the source's getRowBytes(). 0, the default, means no limit.
+    void setMaxResidentBytes(size_t maxBytes)
+    {
+        maxResidentBytes = maxBytes;
+        evictPages();
+    }
+
+    bool isRowLoaded(int rowIdx) { return findLoadedRow(rowIdx) != nullptr; }
+    int getNumResidentPages() const noexcept { return (int) residentPages.size(); }
+    size_t getResidentBytes() const noexcept { return residentBytes; }
+
+    // Called on the message thread after newly loaded pages have been merged
+    std::function<void()> onPagesLoaded;
+
+private:
+    //==============================================================================
+    struct Page
+    {
+        std::vector<RowType> rows;
+        juce::uint32 lastUsed = 0;
+        size_t bytes = 0;
+    };
+
+    struct Request
+    {
+        int page = 0, startRow = 0, numRows = 0;
+        juce::uint32 pageVersion = 0, structureVersion = 0;
+    };
+
+    struct Result
+    {
+        Request request;
+        std::vector<RowType> rows;
+        size_t bytes = 0;
+    };
+
+    class Loader : public juce::Thread
+    {
+    public:
+        Loader(PagedListBoxItemData& o) : juce::Thread("Paged row loader"), owner(o) {}
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                Request request;
+
+                if (!owner.popRequest(request))
+                {
+                    wait(-1);
+                    continue;
+                }
+
+                Result result { request, owner.source.loadRows(request.startRow, request.numRows) };
+
+                for (auto& row : result.rows)
+                    result.bytes += owner.source.getRowBytes(row);
+
+                owner.pushResult(std::move(result));
+            }
+        }
+
+    private:
+        PagedListBoxItemData& owner;
+    };
+
+    //==============================================================================
+    int getPageForRow(int rowIdx) const noexcept { return rowIdx / rowsPerPage; }
+
+    RowType* findLoadedRow(int rowIdx)
+    {
+        if (rowIdx < 0) { return nullptr; }
+
+        auto it = residentPages.find(getPageForRow(rowIdx));
+        if (it == residentPages.end()) { return nullptr; }
+
+        auto& page = it->second;
+        const auto offset = (size_t) (rowIdx % rowsPerPage);
+        if (offset >= page.rows.size()) { return nullptr; }
+
+        page.lastUsed = ++useCounter;
+        return &page.rows[offset];
+    }
+
+    void requestPage(int page)
+    {
+        if (residentPages.count(page) != 0 || pendingPages.count(page) != 0)
+            return;
+
+        const int startRow = page * rowsPerPage;
+        const int numRows = juce::jmin(rowsPerPage, size() - startRow);
+        if (numRows <= 0) { return; }
+
+        pendingPages.insert(page);
+
+        const juce::ScopedLock sl(lock);
+        // newest requests first, as they're closest to what's on screen now
+        requests.push_front({ page, startRow, numRows, pageVersions[page], structureVersion });
+
+        // don't let a fast scroll queue up pages that will be evicted anyway
+        while ((int) requests.size() > maxResidentPages)
+        {
+            pendingPages.erase(requests.back().page);
+            requests.pop_back();
+        }
+
+        loader.notify();
+    }
+
+    void invalidatePendingLoad(int page)
+    {
+        if (pendingPages.count(page) != 0)
+            ++pageVersions[page];
+    }
+
+    bool popRequest(Request& request)
+    {
+        const juce::ScopedLock sl(lock);
+        if (requests.empty()) { return false; }
+
+        request = requests.front();
+        requests.pop_front();
+        return true;
+    }
+
+    void pushResult(Result&& result)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+            results.push_back(std::move(result));
+        }
+
+        triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        std::vector<Result> loaded;
+        {
+            const juce::ScopedLock sl(lock);
+            loaded.swap(results);
+        }
+
+        for (auto& result : loaded)
+        {
+            const auto page = result.request.page;
+
+            // a row was dropped since the request, the page might not even be
+            // wanted any more, so wait for the next paint to ask again
+            if (result.request.structureVersion != structureVersion)
+                continue;
+
+            pendingPages.erase(page);
+
+            // a row on this page was swapped while it was loading
+            if (result.request.pageVersion != pageVersions[page])
+            {
+                requestPage(page);
+                continue;
+            }
+
+            erasePage(residentPages.find(page));
+            residentBytes += result.bytes;
+            residentPages[page] = { std::move(result.rows), ++useCounter, result.bytes };
+        }
+
+        evictPages();
+
+        if (onPagesLoaded != nullptr)
+            onPagesLoaded();
+    }
+
+    void evictPages()
+    {
+        // never evict the dragged row, the next swap needs it
+        const int pinnedPage = dragRowIdx >= 0 ? getPageForRow(dragRowIdx) : -1;
+
+        while ((int) residentPages.size() > maxResidentPages
+                || (maxResidentBytes > 0 && residentBytes > maxResidentBytes))
+        {
+            auto oldest = residentPages.end();
+
+            for (auto it = residentPages.begin(); it != residentPages.end(); ++it)
+                if (it->first != pinnedPage && (oldest == residentPages.end() || it->second.lastUsed < oldest->second.lastUsed))
+                    oldest = it;
+
+            if (oldest == residentPages.end()) { break; }
+            erasePage(oldest);
+        }
+    }
+
+    typename std::unordered_map<int, Page>::iterator erasePage(typename std::unordered_map<int, Page>::iterator it)
+    {
+        if (it == residentPages.end()) { return it; }
+
+        residentBytes -= it->second.bytes;
+        return residentPages.erase(it);
+    }
+
+    //==============================================================================
+    PagedRowSource<RowType>& source;
+    const int rowsPerPage;
+    const int maxResidentPages;
+    size_t maxResidentBytes = 0;
+    int prefetchDistance = 2;
+    int dragDirection = 0;
+
+    // message thread only
+    std::unordered_map<int, Page> residentPages;
+    size_t residentBytes = 0;
+    std::unordered_set<int> pendingPages;
+    std::unordered_map<int, juce::uint32> pageVersions;
+    juce::uint32 structureVersion = 0, useCounter = 0;
+
+    // shared with the loader thread
+    juce::CriticalSection lock;
+    std::deque<Request> requests;
+    std::vector<Result> results;
+
+    Loader loader { *this };
+
+    JUCE_DECLARE_NON_COPYABLE(PagedListBoxItemData)
+};
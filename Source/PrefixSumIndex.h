@@ -0,0 +1,130 @@
+#pragma once
+#include "JuceHeader.h"
+#include <vector>
+
+//==============================================================================
+
+// Fenwick tree over a list of non-negative integer values (e.g. row heights).
+// Point updates, prefix sums and finding the value containing a position are
+// all O(log n), so lookups stay cheap while rows are being dragged around a
+// very long list. Inserting or removing values needs an O(n) rebuild().
+class PrefixSumIndex
+{
+public:
+    PrefixSumIndex() = default;
+
+    // Rebuilds the index in O(n) from getValue(index) for index in [0, numValues)
+    template <typename ValueFunction>
+    void rebuild(int numValues, ValueFunction&& getValue)
+    {
+        values.resize((size_t) juce::jmax(0, numValues));
+        tree.assign(values.size() + 1, 0);
+
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = getValue((int) i);
+            jassert(values[i] >= 0);
+            tree[i + 1] = values[i];
+        }
+
+        for (size_t i = 1; i < tree.size(); ++i)
+        {
+            auto parent = i + (i & (~i + 1));
+
+            if (parent < tree.size())
+                tree[parent] += tree[i];
+        }
+
+        highestStep = 1;
+        while (highestStep * 2 <= values.size())
+            highestStep *= 2;
+    }
+
+    void clear() { rebuild(0, [](int) { return 0; }); }
+
+    int size() const noexcept { return (int) values.size(); }
+
+    int getValue(int index) const
+    {
+        jassert(juce::isPositiveAndBelow(index, size()));
+        return values[(size_t) index];
+    }
+
+    void setValue(int index, int newValue)
+    {
+        jassert(juce::isPositiveAndBelow(index, size()) && newValue >= 0);
+        const juce::int64 delta = newValue - values[(size_t) index];
+        values[(size_t) index] = newValue;
+
+        if (delta == 0)
+            return;
+
+        for (auto i = (size_t) index + 1; i < tree.size(); i += i & (~i + 1))
+            tree[i] += delta;
+    }
+
+    void swapValues(int a, int b)
+    {
+        const auto valueA = getValue(a);
+        setValue(a, getValue(b));
+        setValue(b, valueA);
+    }
+
+    // Moves the value at from to to, shifting the values in between by one,
+    // like a row being dragged there. O(|to - from| log n).
+    void moveValue(int from, int to)
+    {
+        if (from == to)
+            return;
+
+        const auto moved = getValue(from);
+        const int step = to > from ? 1 : -1;
+
+        for (int i = from; i != to; i += step)
+            setValue(i, getValue(i + step));
+
+        setValue(to, moved);
+    }
+
+    // Sum of the values [0, index)
+    juce::int64 getPrefixSum(int index) const
+    {
+        jassert(index >= 0 && index <= size());
+        juce::int64 sum = 0;
+
+        for (auto i = (size_t) index; i > 0; i -= i & (~i + 1))
+            sum += tree[i];
+
+        return sum;
+    }
+
+    juce::int64 getTotal() const { return getPrefixSum(size()); }
+
+    // Returns the index whose span [prefix(i), prefix(i) + value(i)) contains
+    // position, or -1 if position is outside [0, total). Zero-sized values
+    // never contain anything, so this also finds the n-th non-zero entry of
+    // a list of 0/1 flags.
+    int findIndexContaining(juce::int64 position) const
+    {
+        if (position < 0)
+            return -1;
+
+        size_t index = 0;
+
+        for (auto step = highestStep; step > 0 && ! values.empty(); step >>= 1)
+        {
+            if (index + step < tree.size() && tree[index + step] <= position)
+            {
+                index += step;
+                position -= tree[index];
+            }
+        }
+
+        return index < values.size() ? (int) index : -1;
+    }
+
+private:
+    std::vector<int> values;
+    std::vector<juce::int64> tree { 0 };   // 1-based, tree[0] is unused
+    size_t highestStep = 1;
+};
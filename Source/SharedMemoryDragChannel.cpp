@@ -0,0 +1,315 @@
+#include "SharedMemoryDragChannel.h"
+
+#if JUCE_LINUX || JUCE_BSD
+ #include <atomic>
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+
+//==============================================================================
+
+
+namespace
+{
+    const juce::String handlePrefix("juce-draggablelistbox-shm:");
+
+   #if JUCE_LINUX || JUCE_BSD
+    constexpr juce::uint32 segmentMagic = 0x444c4253; // "DLBS"
+
+    // values of SegmentHeader::consumed
+    enum : juce::uint32
+    {
+        available = 0,
+        claimed   = 1,
+        withdrawn = 2,
+        committed = 3
+    };
+
+    struct SegmentHeader
+    {
+        juce::uint32 magic;
+        std::atomic<juce::uint32> consumed;
+        juce::uint64 payloadSize;
+    };
+
+    static_assert(std::atomic<juce::uint32>::is_always_lock_free,
+                  "the consumed flag is shared between processes, so it must be lock-free");
+
+    juce::String getSegmentName(const juce::String& handle)
+    {
+        return handle.fromFirstOccurrenceOf(handlePrefix, false, false);
+    }
+
+    // Maps the whole segment, returns nullptr if it doesn't exist or isn't one of ours
+    SegmentHeader* mapSegment(const juce::String& handle, bool writable, size_t& mappedSize)
+    {
+        const auto name = getSegmentName(handle);
+        if (name.isEmpty()) { return nullptr; }
+
+        const int fd = shm_open(name.toRawUTF8(), writable ? O_RDWR : O_RDONLY, 0);
+        if (fd < 0) { return nullptr; }
+
+        struct stat info;
+        void* mapping = MAP_FAILED;
+
+        if (fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(SegmentHeader))
+        {
+            mappedSize = (size_t) info.st_size;
+            mapping = mmap(nullptr, mappedSize, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+        }
+
+        close(fd);
+
+        if (mapping == MAP_FAILED) { return nullptr; }
+
+        auto* header = static_cast<SegmentHeader*>(mapping);
+
+        if (header->magic != segmentMagic || header->payloadSize > mappedSize - sizeof(SegmentHeader))
+        {
+            munmap(mapping, mappedSize);
+            return nullptr;
+        }
+
+        return header;
+    }
+   #endif
+}
+
+juce::String SharedMemoryDragChannel::publish(const void* data, size_t numBytes)
+{
+   #if JUCE_LINUX || JUCE_BSD
+    static std::atomic<int> counter { 0 };
+
+    // segment names must start with a slash and contain no others
+    const auto name = "/juce-dlb-" + juce::String(getpid()) + "-" + juce::String(++counter)
+                        + "-" + juce::String::toHexString(juce::Random::getSystemRandom().nextInt());
+
+    const int fd = shm_open(name.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) { return {}; }
+
+    const auto totalSize = sizeof(SegmentHeader) + numBytes;
+    void* mapping = MAP_FAILED;
+
+    if (ftruncate(fd, (off_t) totalSize) == 0)
+        mapping = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        shm_unlink(name.toRawUTF8());
+        return {};
+    }
+
+    auto* header = new (mapping) SegmentHeader();
+    header->consumed.store(available);
+    header->payloadSize = numBytes;
+
+    if (numBytes > 0)
+        memcpy(reinterpret_cast<char*>(header + 1), data, numBytes);
+
+    // written last, so a reader never sees a half-filled segment as valid
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = segmentMagic;
+
+    munmap(mapping, totalSize);
+    return handlePrefix + name;
+   #else
+    juce::ignoreUnused(data, numBytes);
+    return {};
+   #endif
+}
+
+bool SharedMemoryDragChannel::isHandle(const juce::String& text)
+{
+    return text.startsWith(handlePrefix);
+}
+
+bool SharedMemoryDragChannel::wasConsumed(const juce::String& handle)
+{
+   #if JUCE_LINUX || JUCE_BSD
+    size_t mappedSize = 0;
+    auto* header = mapSegment(handle, false, mappedSize);
+    if (header == nullptr) { return false; }
+
+    const bool consumed = header->consumed.load() == committed;
+    munmap(header, mappedSize);
+    return consumed;
+   #else
+    juce::ignoreUnused(handle);
+    return false;
+   #endif
+}
+
+SharedMemoryDragChannel::WithdrawResult SharedMemoryDragChannel::withdraw(const juce::String& handle)
+{
+   #if JUCE_LINUX || JUCE_BSD
+    size_t mappedSize = 0;
+    auto* header = mapSegment(handle, true, mappedSize);
+
+    // nobody else can open it either
+    if (header == nullptr) { return WithdrawResult::withdrawn; }
+
+    juce::uint32 state = available;
+    const bool wasAvailable = header->consumed.compare_exchange_strong(state, withdrawn);
+    munmap(header, mappedSize);
+
+    if (wasAvailable || state == withdrawn)
+        return WithdrawResult::withdrawn;
+
+    return state == committed ? WithdrawResult::consumed : WithdrawResult::claimed;
+   #else
+    juce::ignoreUnused(handle);
+    return WithdrawResult::withdrawn;
+   #endif
+}
+
+void SharedMemoryDragChannel::release(const juce::String& handle)
+{
+   #if JUCE_LINUX || JUCE_BSD
+    // readers that still have it mapped keep their mapping
+    const auto name = getSegmentName(handle);
+
+    if (name.isNotEmpty())
+        shm_unlink(name.toRawUTF8());
+   #else
+    juce::ignoreUnused(handle);
+   #endif
+}
+
+
+//==============================================================================
+
+
+SharedMemoryDragChannel::Reader::Reader(const juce::String& handle)
+{
+   #if JUCE_LINUX || JUCE_BSD
+    if (auto* header = mapSegment(handle, true, mappingSize))
+    {
+        mapping = header;
+        payload = header + 1;
+        payloadSize = (size_t) header->payloadSize;
+    }
+   #else
+    juce::ignoreUnused(handle);
+   #endif
+}
+
+SharedMemoryDragChannel::Reader::~Reader()
+{
+   #if JUCE_LINUX || JUCE_BSD
+    if (mapping != nullptr)
+        munmap(mapping, mappingSize);
+   #endif
+}
+
+bool SharedMemoryDragChannel::Reader::claim()
+{
+   #if JUCE_LINUX || JUCE_BSD
+    if (mapping == nullptr) { return false; }
+
+    // fails once another receiver claimed it or the sender withdrew it
+    juce::uint32 expected = available;
+    return static_cast<SegmentHeader*>(mapping)->consumed.compare_exchange_strong(expected, claimed);
+   #else
+    return false;
+   #endif
+}
+
+void SharedMemoryDragChannel::Reader::commit()
+{
+   #if JUCE_LINUX || JUCE_BSD
+    if (mapping == nullptr) { return; }
+
+    juce::uint32 expected = claimed;
+    const bool wasClaimed = static_cast<SegmentHeader*>(mapping)->consumed.compare_exchange_strong(expected, committed);
+    jassertquiet(wasClaimed); // commit() needs a successful claim() first
+   #endif
+}
+
+void SharedMemoryDragChannel::Reader::unclaim()
+{
+   #if JUCE_LINUX || JUCE_BSD
+    if (mapping == nullptr) { return; }
+
+    juce::uint32 expected = claimed;
+    static_cast<SegmentHeader*>(mapping)->consumed.compare_exchange_strong(expected, available);
+   #endif
+}
+
+
+//==============================================================================
+
+
+juce::String SharedMemoryDragChannel::LatencyReport::toString() const
+{
+    juce::String s;
+    s << juce::String((juce::int64) payloadBytes) << " bytes: " << numRuns << " transfers"
+      << ", mean " << juce::String(meanMs, 3) << " ms"
+      << ", max " << juce::String(maxMs, 3) << " ms";
+
+    if (numFailed > 0)
+        s << ", " << numFailed << " failed";
+
+    return s;
+}
+
+SharedMemoryDragChannel::LatencyReport SharedMemoryDragChannel::measureLatency(size_t payloadBytes, int numRuns)
+{
+    LatencyReport report;
+    report.payloadBytes = payloadBytes;
+
+    juce::MemoryBlock source(payloadBytes), received(payloadBytes);
+    juce::Random random(1);
+    random.fillBitsRandomly(source.getData(), source.getSize());
+
+    double totalMs = 0.0;
+
+    for (int run = 0; run < numRuns; ++run)
+    {
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+        bool ok = false;
+
+        const auto handle = publish(source.getData(), source.getSize());
+
+        if (handle.isNotEmpty())
+        {
+            {
+                // what the receiving list does in textDropped()
+                Reader reader(handle);
+
+                if (reader.isValid() && reader.getSize() == payloadBytes && reader.claim())
+                {
+                    if (payloadBytes > 0)
+                        memcpy(received.getData(), reader.getData(), payloadBytes);
+
+                    reader.commit();
+                    ok = true;
+                }
+            }
+
+            // and what the sending list does once the drag has finished
+            ok = ok && withdraw(handle) == WithdrawResult::consumed;
+            release(handle);
+        }
+
+        const auto elapsed = juce::Time::getMillisecondCounterHiRes() - start;
+        ++report.numRuns;
+
+        if (!ok || received != source)
+        {
+            ++report.numFailed;
+            continue;
+        }
+
+        totalMs += elapsed;
+        report.maxMs = juce::jmax(report.maxMs, elapsed);
+    }
+
+    const int numSucceeded = report.numRuns - report.numFailed;
+    report.meanMs = numSucceeded > 0 ? totalMs / numSucceeded : 0.0;
+    return report;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "JuceHeader.h"
+
+//==============================================================================
+
+// Hands a block of bytes to another process through a POSIX shared-memory
+// segment, so that only a short handle string has to travel with an external
+// drag. The sender publish()es the payload and release()s it once the drag is
+// over, and a receiver opens it with a Reader, claim()s it and commit()s once
+// it has used it. Before keeping the payload itself, the sender must
+// withdraw() it, which atomically stops any receiver from claiming it later,
+// so the payload ends up with exactly one side.
+//
+// Only implemented on Linux and BSD, elsewhere publish() fails.
+class SharedMemoryDragChannel
+{
+public:
+    // Returns the handle of a new segment holding a copy of data, or an empty
+    // string if it couldn't be created.
+    static juce::String publish(const void* data, size_t numBytes);
+    static bool isHandle(const juce::String& text);
+
+    // True once a receiver has committed the payload
+    static bool wasConsumed(const juce::String& handle);
+
+    enum class WithdrawResult
+    {
+        withdrawn,  // no receiver has it, and none can claim it from now on
+        consumed,   // a receiver committed it
+        claimed     // a receiver is using it right now, ask again shortly
+    };
+
+    static WithdrawResult withdraw(const juce::String& handle);
+    static void release(const juce::String& handle);
+
+    // Maps a published segment into this process. The bytes are read straight
+    // from the mapping, nothing is copied.
+    class Reader
+    {
+    public:
+        explicit Reader(const juce::String& handle);
+        ~Reader();
+
+        bool isValid() const noexcept { return payload != nullptr; }
+        const void* getData() const noexcept { return payload; }
+        size_t getSize() const noexcept { return payloadSize; }
+
+        // Marks the payload as being taken. Only the first caller gets true,
+        // and nobody does once the sender has withdrawn it, so the row can't
+        // end up in two places. Call commit() once the row has been inserted,
+        // or unclaim() if it couldn't be after all.
+        bool claim();
+        void commit();
+        void unclaim();
+
+    private:
+        void* mapping = nullptr;
+        size_t mappingSize = 0;
+        const void* payload = nullptr;
+        size_t payloadSize = 0;
+
+        JUCE_DECLARE_NON_COPYABLE(Reader)
+    };
+
+    // Timings of handing numBytes from publish() to a Reader and back to
+    // release(), all within this process, i.e. what a drag costs besides the
+    // OS drag itself.
+    struct LatencyReport
+    {
+        size_t payloadBytes = 0;
+        int numRuns = 0, numFailed = 0;
+        double meanMs = 0.0, maxMs = 0.0;
+
+        juce::String toString() const;
+    };
+
+    static LatencyReport measureLatency(size_t payloadBytes, int numRuns);
+};
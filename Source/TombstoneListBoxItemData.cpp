@@ -0,0 +1,113 @@
+#include "TombstoneListBoxItemData.h"
+#include <algorithm>
+
+
+//==============================================================================
+
+
+void TombstoneListBoxItemData::storedRowsAdded()
+{
+    const int numOld = aliveFlags.size();
+    std::vector<int> oldFlags((size_t) numOld);
+
+    for (int i = 0; i < numOld; ++i)
+        oldFlags[(size_t) i] = aliveFlags.getValue(i);
+
+    aliveFlags.rebuild(getNumStoredRows(), [&](int i) { return i < numOld ? oldFlags[(size_t) i] : 1; });
+}
+
+void TombstoneListBoxItemData::paintRow(DraggableListBoxItem* item, int rowIdx, juce::Graphics& g, juce::Rectangle<int> bounds)
+{
+    const int storedIdx = toStoredIndex(rowIdx);
+    if (storedIdx < 0) { return; }
+
+    paintStoredRow(item, storedIdx, rowIdx, g, bounds);
+}
+
+void TombstoneListBoxItemData::swapRows(int rowIdx1, int rowIdx2)
+{
+    // both are alive, so the flags don't change
+    swapStoredRows(toStoredIndex(rowIdx1), toStoredIndex(rowIdx2));
+}
+
+juce::int64 TombstoneListBoxItemData::getRowId(int idx)
+{
+    const int storedIdx = toStoredIndex(idx);
+    return storedIdx >= 0 ? getStoredRowId(storedIdx) : -1;
+}
+
+void TombstoneListBoxItemData::deleteRow(int idx)
+{
+    const int storedIdx = toStoredIndex(idx);
+    if (storedIdx < 0) { return; }
+
+    aliveFlags.setValue(storedIdx, 0);
+    ++numTombstones;
+    undoStack.push_back(storedIdx);
+
+    if (numTombstones - juce::jmin((int) undoStack.size(), maxUndoDepth) > maxPendingTombstones)
+        compact();
+    else
+        startTimer(compactionDelayMs);
+}
+
+int TombstoneListBoxItemData::restoreLastDeletedRow()
+{
+    if (undoStack.empty()) { return -1; }
+
+    const int storedIdx = undoStack.back();
+    undoStack.pop_back();
+
+    aliveFlags.setValue(storedIdx, 1);
+    --numTombstones;
+    return toRowIndex(storedIdx);
+}
+
+void TombstoneListBoxItemData::setCompactionPolicy(int idleMilliseconds, int maxTombstones, int maxRestorableRows)
+{
+    compactionDelayMs = juce::jmax(1, idleMilliseconds);
+    maxPendingTombstones = juce::jmax(0, maxTombstones);
+    maxUndoDepth = juce::jmax(0, maxRestorableRows);
+}
+
+void TombstoneListBoxItemData::compact()
+{
+    stopTimer();
+
+    // the oldest deletions are forgotten, the rest stay restorable
+    const auto numForgotten = undoStack.size() - juce::jmin(undoStack.size(), (size_t) maxUndoDepth);
+    undoStack.erase(undoStack.begin(), undoStack.begin() + (std::ptrdiff_t) numForgotten);
+
+    std::vector<int> kept(undoStack);
+    std::sort(kept.begin(), kept.end());
+
+    std::vector<int> removed;
+    removed.reserve((size_t) (numTombstones - (int) kept.size()));
+
+    for (int i = 0; i < aliveFlags.size(); ++i)
+        if (aliveFlags.getValue(i) == 0 && !std::binary_search(kept.begin(), kept.end(), i))
+            removed.push_back(i);
+
+    if (removed.empty()) { return; }
+
+    removeStoredRows(removed);
+
+    // the restorable rows move up by the number of rows removed before them
+    for (auto& storedIdx : undoStack)
+        storedIdx -= (int) (std::lower_bound(removed.begin(), removed.end(), storedIdx) - removed.begin());
+
+    for (auto& storedIdx : kept)
+        storedIdx -= (int) (std::lower_bound(removed.begin(), removed.end(), storedIdx) - removed.begin());
+
+    jassert(getNumStoredRows() == aliveFlags.size() - (int) removed.size());
+    aliveFlags.rebuild(getNumStoredRows(), [&](int i) { return std::binary_search(kept.begin(), kept.end(), i) ? 0 : 1; });
+    numTombstones = (int) kept.size();
+}
+
+void TombstoneListBoxItemData::timerCallback()
+{
+    // the O(n) pass would stall a drag, wait until it's over
+    if (dragRowIdx >= 0) { return; }
+
+    compact();
+}
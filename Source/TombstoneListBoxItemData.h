@@ -0,0 +1,77 @@
+#pragma once
+#include "JuceHeader.h"
+#include "DraggableListBox.h"
+#include "PrefixSumIndex.h"
+#include <vector>
+
+//==============================================================================
+
+// Row data whose deleted rows are only marked as gone (a tombstone) and are
+// hidden straight away. They're removed from your storage later, all at once,
+// when the list has been idle for a moment or when too many have piled up.
+// Dragging a dozen rows out one after the other therefore costs a dozen
+// O(log n) updates instead of a dozen O(n) removals. Recently deleted rows
+// can be brought back with restoreLastDeletedRow(), which just clears the
+// tombstone.
+//
+// Your class works on "stored" indices into its storage, which includes the
+// rows that are deleted but not yet removed. The list's row indices are
+// mapped onto them through a PrefixSumIndex of alive flags, in O(log n).
+class TombstoneListBoxItemData
+    : public DraggableListBoxItemData
+    , private juce::Timer
+{
+public:
+    TombstoneListBoxItemData() = default;
+
+    virtual int getNumStoredRows() = 0;
+    virtual void paintStoredRow(DraggableListBoxItem* item, int storedIdx, int rowIdx,
+                                juce::Graphics& g, juce::Rectangle<int> bounds) = 0;
+    virtual void swapStoredRows(int storedIdx1, int storedIdx2) = 0;
+
+    // Remove all of these rows from your storage, in one pass if you can.
+    // The indices are sorted in increasing order.
+    virtual void removeStoredRows(const std::vector<int>& storedIndices) = 0;
+
+    virtual juce::int64 getStoredRowId(int /*storedIdx*/) { return -1; }
+
+    // Call after adding rows to the end of your storage, O(n)
+    void storedRowsAdded();
+
+    // Brings back the most recently deleted row that is still remembered, and
+    // returns its row index or -1 if there's none. Call updateContent() on the
+    // list afterwards.
+    int restoreLastDeletedRow();
+    int getNumRestorableRows() const noexcept { return (int) undoStack.size(); }
+
+    // Removes every tombstone except the restorable ones from your storage
+    void compact();
+
+    // Compaction happens after idleMilliseconds without a deletion, or right
+    // away once more than maxTombstones rows are waiting. The last
+    // maxRestorableRows deleted rows are kept back for restoring.
+    void setCompactionPolicy(int idleMilliseconds, int maxTombstones, int maxRestorableRows);
+
+    int toStoredIndex(int rowIdx) const { return aliveFlags.findIndexContaining(rowIdx); }
+    int toRowIndex(int storedIdx) const { return (int) aliveFlags.getPrefixSum(storedIdx); }
+
+    // DraggableListBoxItemData
+    void paintRow(DraggableListBoxItem* item, int rowIdx, juce::Graphics& g, juce::Rectangle<int> bounds) override;
+    int size() override { return (int) aliveFlags.getTotal(); }
+    void swapRows(int rowIdx1, int rowIdx2) override;
+    void deleteRow(int idx) override;
+    juce::int64 getRowId(int idx) override;
+
+private:
+    void timerCallback() override;
+
+    PrefixSumIndex aliveFlags;
+    std::vector<int> undoStack;     // stored indices, most recent last
+    int numTombstones = 0;
+
+    int compactionDelayMs = 1000;
+    int maxPendingTombstones = 256;
+    int maxUndoDepth = 32;
+
+    JUCE_DECLARE_NON_COPYABLE(TombstoneListBoxItemData)
+};
@@ -0,0 +1,174 @@
+#include "VariableHeightListBox.h"
+
+
+//==============================================================================
+
+
+VariableHeightDraggableListBox::VariableHeightDraggableListBox(VariableHeightListBoxItemData& md)
+    : modelData(md)
+{
+    viewport.setViewedComponent(&rowHolder, false);
+    viewport.setScrollBarsShown(true, false);
+    addAndMakeVisible(viewport);
+
+    updateContent();
+}
+
+void VariableHeightDraggableListBox::updateContent()
+{
+    heights.rebuild(modelData.size(), [this](int rowIdx) { return juce::jmax(0, modelData.getRowHeight(rowIdx)); });
+    updateContentSize();
+    updateVisibleRows();
+}
+
+void VariableHeightDraggableListBox::rowHeightChanged(int rowIdx)
+{
+    if (!isPositiveAndBelow(rowIdx, heights.size())) { return; }
+
+    heights.setValue(rowIdx, juce::jmax(0, modelData.getRowHeight(rowIdx)));
+    updateContentSize();
+    updateVisibleRows();
+}
+
+int VariableHeightDraggableListBox::getRowContainingPosition(int x, int y) const
+{
+    if (!isPositiveAndBelow(x, getWidth()) || !isPositiveAndBelow(y, getHeight()))
+        return -1;
+
+    return heights.findIndexContaining((juce::int64) y + viewport.getViewPositionY());
+}
+
+juce::Rectangle<int> VariableHeightDraggableListBox::getRowPosition(int rowIdx, bool relativeToComponentTopLeft) const
+{
+    if (!isPositiveAndBelow(rowIdx, heights.size()))
+        return {};
+
+    auto y = (int) heights.getPrefixSum(rowIdx);
+
+    if (relativeToComponentTopLeft)
+        y -= viewport.getViewPositionY();
+
+    return { 0, y, rowHolder.getWidth(), heights.getValue(rowIdx) };
+}
+
+void VariableHeightDraggableListBox::scrollToEnsureRowIsOnscreen(int rowIdx)
+{
+    auto row = getRowPosition(rowIdx, false);
+    if (row.isEmpty()) { return; }
+
+    const auto viewTop = viewport.getViewPositionY();
+    const auto viewHeight = viewport.getMaximumVisibleHeight();
+
+    if (row.getY() < viewTop)
+        viewport.setViewPosition(0, row.getY());
+    else if (row.getBottom() > viewTop + viewHeight)
+        viewport.setViewPosition(0, row.getBottom() - viewHeight);
+}
+
+void VariableHeightDraggableListBox::resized()
+{
+    viewport.setBounds(getLocalBounds());
+    updateContentSize();
+    updateVisibleRows();
+}
+
+void VariableHeightDraggableListBox::updateContentSize()
+{
+    rowHolder.setSize(viewport.getMaximumVisibleWidth(), (int) heights.getTotal());
+}
+
+void VariableHeightDraggableListBox::updateVisibleRows()
+{
+    const auto viewTop = (juce::int64) viewport.getViewPositionY();
+    const auto viewBottom = viewTop + viewport.getMaximumVisibleHeight();
+
+    int firstRow = heights.findIndexContaining(viewTop);
+    int lastRow = heights.findIndexContaining(viewBottom - 1);
+
+    if (lastRow < 0)
+        lastRow = heights.size() - 1;
+
+    const int numVisible = firstRow < 0 ? 0 : lastRow - firstRow + 1;
+
+    while (rowComponents.size() < numVisible)
+        rowHolder.addChildComponent(rowComponents.add(new DraggableListBoxItem(modelData, -1)));
+
+    for (int i = 0; i < rowComponents.size(); ++i)
+    {
+        auto* item = rowComponents.getUnchecked(i);
+
+        if (i < numVisible)
+        {
+            const int rowIdx = firstRow + i;
+            item->setBounds(0, (int) heights.getPrefixSum(rowIdx), rowHolder.getWidth(), heights.getValue(rowIdx));
+            item->setVisible(true);
+            // rows are bound by position, so the content may have changed
+            // even if the bounds didn't
+            item->bindToRow(rowIdx);
+        }
+        else
+        {
+            item->setVisible(false);
+        }
+    }
+}
+
+
+//==============================================================================
+
+
+void VariableHeightDraggableListBox::itemDragMove(const SourceDetails& dragSourceDetails)
+{
+    int mouseOverIdx = getRowContainingPosition(dragSourceDetails.localPosition.x,
+        dragSourceDetails.localPosition.y);
+    if (mouseOverIdx == -1) { return; } // failed finding row
+
+    // the first drag move arrives before the dragged row has been recorded
+    const int dragIdx = modelData.dragRowIdx;
+    if (dragIdx < 0) { return; }
+
+    if (mouseOverIdx == dragIdx)
+    {
+        return;
+    }
+
+    // Only move once the mouse is inside the slot the dragged row would take
+    // up at the target. Otherwise a short row dragged onto a tall one would
+    // leave the mouse over the tall row again and be moved straight back.
+    const auto y = (juce::int64) dragSourceDetails.localPosition.y + viewport.getViewPositionY();
+    const auto draggedHeight = heights.getValue(dragIdx);
+    int targetIdx = mouseOverIdx;
+
+    if (mouseOverIdx > dragIdx && y < heights.getPrefixSum(mouseOverIdx + 1) - draggedHeight)
+        --targetIdx;
+    else if (mouseOverIdx < dragIdx && y >= heights.getPrefixSum(mouseOverIdx) + draggedHeight)
+        ++targetIdx;
+
+    if (targetIdx == dragIdx) { return; }
+
+    // rows skipped by a fast drag keep their order
+    modelData.dragRowIdx = modelData.moveRow(dragIdx, targetIdx);
+    jassert(modelData.dragRowIdx == targetIdx);
+    heights.moveValue(dragIdx, targetIdx);
+    updateVisibleRows();
+}
+
+void VariableHeightDraggableListBox::itemDragEnter(const SourceDetails& dragSourceDetails)
+{
+    modelData.draggingOutsideContainer = false;
+}
+void VariableHeightDraggableListBox::itemDragExit(const SourceDetails& dragSourceDetails)
+{
+    modelData.draggingOutsideContainer = true;
+}
+
+void VariableHeightDraggableListBox::dragOperationEnded(const DropTarget::SourceDetails& dragSourceDetails)
+{
+    const bool rowDeleted = modelData.endDrag(dragCancelled);
+    dragCancelled = false;
+
+    if (rowDeleted)
+        updateContent();
+    else
+        updateVisibleRows();
+}
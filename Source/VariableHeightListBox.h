@@ -0,0 +1,81 @@
+#pragma once
+#include "JuceHeader.h"
+#include "DraggableListBox.h"
+#include "PrefixSumIndex.h"
+
+//==============================================================================
+
+// Row data for lists whose rows don't all share the same height
+class VariableHeightListBoxItemData : public DraggableListBoxItemData
+{
+public:
+    virtual int getRowHeight(int rowIdx) = 0;
+};
+
+
+//==============================================================================
+
+
+// Drag-to-reorder list whose rows can each have their own height.
+// juce::ListBox assumes a fixed row height, so this lays its rows out itself
+// inside a Viewport. Row offsets are kept in a PrefixSumIndex, which makes
+// position-to-row lookups, layout and height updates O(log n) even during a
+// drag over a very long list. Only the visible rows get a component.
+class VariableHeightDraggableListBox
+    : public juce::Component
+    , public DragContainer
+    , public DropTarget
+{
+public:
+    VariableHeightDraggableListBox(VariableHeightListBoxItemData& md);
+
+    // Call after rows are added or removed. Re-reads every row height, O(n).
+    void updateContent();
+    // Call after a single row changed height, O(log n).
+    void rowHeightChanged(int rowIdx);
+
+    // Positions are relative to this component, -1 means there is no such row
+    int getRowContainingPosition(int x, int y) const;
+    juce::Rectangle<int> getRowPosition(int rowIdx, bool relativeToComponentTopLeft) const;
+    int getRowHeight(int rowIdx) const { return heights.getValue(rowIdx); }
+
+    void scrollToEnsureRowIsOnscreen(int rowIdx);
+    juce::Viewport& getViewport() noexcept { return viewport; }
+
+    void resized() override;
+
+    // DropTarget
+    bool isInterestedInDragSource(const SourceDetails&) override { return true; }
+    void itemDragEnter(const SourceDetails& dragSourceDetails) override;
+    void itemDragExit(const SourceDetails& dragSourceDetails) override;
+    void itemDragMove(const SourceDetails&) override;
+    void itemDropped(const SourceDetails& dragSourceDetails) override {}
+
+protected:
+    void dragOperationEnded(const DropTarget::SourceDetails& dragSourceDetails) override;
+    void dragOperationCancelled(const DropTarget::SourceDetails&) override { dragCancelled = true; }
+
+    VariableHeightListBoxItemData& modelData;
+
+private:
+    class RowViewport : public juce::Viewport
+    {
+    public:
+        RowViewport(VariableHeightDraggableListBox& o) : owner(o) {}
+        void visibleAreaChanged(const juce::Rectangle<int>&) override { owner.updateVisibleRows(); }
+
+    private:
+        VariableHeightDraggableListBox& owner;
+    };
+
+    void updateContentSize();
+    void updateVisibleRows();
+
+    PrefixSumIndex heights;
+    bool dragCancelled = false;
+    juce::Component rowHolder;
+    RowViewport viewport { *this };
+    juce::OwnedArray<DraggableListBoxItem> rowComponents;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VariableHeightDraggableListBox)
+};